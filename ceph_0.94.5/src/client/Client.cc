@@ -147,7 +147,7 @@ bool Client::CommandHook::call(std::string command, cmdmap_t& cmdmap,
 dir_result_t::dir_result_t(Inode *in)
   : inode(in), offset(0), this_offset(2), next_offset(2),
     release_count(0), ordered_count(0), start_shared_gen(0),
-    buffer(0) {
+    buffer(0), prefetching(false) {
   inode->get();
 }
 
@@ -171,6 +171,7 @@ Client::Client(Messenger *m, MonClient *mc)
     interrupt_finisher(m->cct),
     remount_finisher(m->cct),
     objecter_finisher(m->cct),
+    readdir_prefetcher(m->cct),
     tick_event(NULL),
     monclient(mc), messenger(m), whoami(m->get_myname().num()),
     cap_epoch_barrier(0),
@@ -222,6 +223,7 @@ Client::Client(Messenger *m, MonClient *mc)
 				  true);
   objecter_finisher.start();
   filer = new Filer(objecter, &objecter_finisher);
+  readdir_prefetcher.start();
 }
 
 
@@ -517,6 +519,9 @@ void Client::shutdown()
     remount_finisher.stop();
   }
 
+  readdir_prefetcher.wait_for_empty();
+  readdir_prefetcher.stop();
+
   objectcacher->stop();  // outside of client_lock! this does a join.
 
   client_lock.Lock();
@@ -5824,6 +5829,9 @@ int Client::closedir(dir_result_t *dir)
 void Client::_closedir(dir_result_t *dirp)
 {
   ldout(cct, 10) << "_closedir(" << dirp << ")" << dendl;
+  while (dirp->prefetching)
+    dirp->prefetch_cond.Wait(client_lock);
+  _readdir_drop_prefetch(dirp);
   if (dirp->inode) {
     ldout(cct, 10) << "_closedir detaching inode " << dirp->inode << dendl;
     put_inode(dirp->inode);
@@ -5935,6 +5943,40 @@ void Client::_readdir_drop_dirp_buffer(dir_result_t *dirp)
   }
 }
 
+int Client::_readdir_request(Inode *diri, dir_result_t::chunk_t *chunk)
+{
+  int op = CEPH_MDS_OP_READDIR;
+  if (diri->snapid == CEPH_SNAPDIR)
+    op = CEPH_MDS_OP_LSSNAP;
+
+  MetaRequest *req = new MetaRequest(op);
+  filepath path;
+  diri->make_nosnap_relative_path(path);
+  req->set_filepath(path); 
+  req->set_inode(diri);
+  req->head.args.readdir.frag = chunk->req_frag;
+  if (cct->_conf->client_readdir_max_bytes > 0)
+    req->head.args.readdir.max_bytes = cct->_conf->client_readdir_max_bytes;
+  if (chunk->req_start.length()) {
+    req->path2.set_path(chunk->req_start.c_str());
+    req->readdir_start = chunk->req_start;
+  }
+  req->readdir_offset = chunk->req_offset;
+  req->readdir_frag = chunk->req_frag;
+  
+  bufferlist dirbl;
+  int res = make_request(req, -1, -1, NULL, NULL, -1, &dirbl);
+  if (res == 0) {
+    chunk->valid = true;
+    chunk->frag = req->readdir_reply_frag;
+    chunk->end = req->readdir_end;
+    chunk->num = req->readdir_num;
+    chunk->last_name = req->readdir_last_name;
+    chunk->result.swap(req->readdir_result);
+  }
+  return res;
+}
+
 int Client::_readdir_get_frag(dir_result_t *dirp)
 {
   assert(dirp);
@@ -5947,28 +5989,33 @@ int Client::_readdir_get_frag(dir_result_t *dirp)
 	   << " next_offset " << dirp->next_offset
 	   << dendl;
 
-  int op = CEPH_MDS_OP_READDIR;
-  if (dirp->inode && dirp->inode->snapid == CEPH_SNAPDIR)
-    op = CEPH_MDS_OP_LSSNAP;
-
   Inode *diri = dirp->inode;
 
-  MetaRequest *req = new MetaRequest(op);
-  filepath path;
-  diri->make_nosnap_relative_path(path);
-  req->set_filepath(path); 
-  req->set_inode(diri);
-  req->head.args.readdir.frag = fg;
-  if (dirp->last_name.length()) {
-    req->path2.set_path(dirp->last_name.c_str());
-    req->readdir_start = dirp->last_name;
+  while (dirp->prefetching)
+    dirp->prefetch_cond.Wait(client_lock);
+
+  dir_result_t::chunk_t chunk;
+  int res;
+  if (dirp->prefetch.valid &&
+      dirp->prefetch.req_frag == fg &&
+      dirp->prefetch.req_start == dirp->last_name &&
+      dirp->prefetch.req_offset == dirp->next_offset) {
+    ldout(cct, 10) << "_readdir_get_frag using prefetched chunk" << dendl;
+    chunk.valid = true;
+    chunk.frag = dirp->prefetch.frag;
+    chunk.end = dirp->prefetch.end;
+    chunk.num = dirp->prefetch.num;
+    chunk.last_name = dirp->prefetch.last_name;
+    chunk.result.swap(dirp->prefetch.result);
+    dirp->prefetch.valid = false;
+    res = 0;
+  } else {
+    _readdir_drop_prefetch(dirp);
+    chunk.req_frag = fg;
+    chunk.req_start = dirp->last_name;
+    chunk.req_offset = dirp->next_offset;
+    res = _readdir_request(diri, &chunk);
   }
-  req->readdir_offset = dirp->next_offset;
-  req->readdir_frag = fg;
-  
-  
-  bufferlist dirbl;
-  int res = make_request(req, -1, -1, NULL, NULL, -1, &dirbl);
   
   if (res == -EAGAIN) {
     ldout(cct, 10) << "_readdir_get_frag got EAGAIN, retrying" << dendl;
@@ -5983,10 +6030,10 @@ int Client::_readdir_get_frag(dir_result_t *dirp)
     _readdir_drop_dirp_buffer(dirp);
 
     dirp->buffer = new vector<pair<string,Inode*> >;
-    dirp->buffer->swap(req->readdir_result);
+    dirp->buffer->swap(chunk.result);
 
-    if (fg != req->readdir_reply_frag) {
-      fg = req->readdir_reply_frag;
+    if (fg != chunk.frag) {
+      fg = chunk.frag;
       if (fg.is_leftmost())
 	dirp->next_offset = 2;
       else
@@ -5999,15 +6046,16 @@ int Client::_readdir_get_frag(dir_result_t *dirp)
 	     << " this_offset " << dirp->this_offset
 	     << " size " << dirp->buffer->size() << dendl;
 
-    if (req->readdir_end) {
+    if (chunk.end) {
       dirp->last_name.clear();
       if (fg.is_rightmost())
 	dirp->next_offset = 2;
       else
 	dirp->next_offset = 0;
     } else {
-      dirp->last_name = req->readdir_last_name;
-      dirp->next_offset += req->readdir_num;
+      dirp->last_name = chunk.last_name;
+      dirp->next_offset += chunk.num;
+      _readdir_start_prefetch(dirp);
     }
   } else {
     ldout(cct, 10) << "_readdir_get_frag got error " << res << ", setting end flag" << dendl;
@@ -6017,6 +6065,61 @@ int Client::_readdir_get_frag(dir_result_t *dirp)
   return res;
 }
 
+class C_Client_ReaddirPrefetch : public Context {
+  Client *client;
+  dir_result_t *dirp;
+public:
+  C_Client_ReaddirPrefetch(Client *c, dir_result_t *d) : client(c), dirp(d) {}
+  void finish(int r) {
+    client->_readdir_prefetch(dirp);
+  }
+};
+
+/*
+ * queue a request for the rest of the current frag so it is (likely)
+ * here by the time the caller has consumed dirp->buffer.
+ */
+void Client::_readdir_start_prefetch(dir_result_t *dirp)
+{
+  if (!cct->_conf->client_readdir_prefetch ||
+      dirp->prefetching ||
+      dirp->inode->snapid == CEPH_SNAPDIR)
+    return;
+
+  _readdir_drop_prefetch(dirp);
+  dirp->prefetch.req_frag = dirp->buffer_frag;
+  dirp->prefetch.req_start = dirp->last_name;
+  dirp->prefetch.req_offset = dirp->next_offset;
+  ldout(cct, 10) << "_readdir_start_prefetch " << dirp << " fg " << dirp->buffer_frag
+		 << " after '" << dirp->last_name << "'" << dendl;
+  dirp->prefetching = true;
+  readdir_prefetcher.queue(new C_Client_ReaddirPrefetch(this, dirp));
+}
+
+void Client::_readdir_prefetch(dir_result_t *dirp)
+{
+  Mutex::Locker lock(client_lock);
+  assert(dirp->prefetching);
+
+  // _closedir and _readdir_get_frag wait for us, so dirp->inode is safe
+  if (!unmounting) {
+    int r = _readdir_request(dirp->inode, &dirp->prefetch);
+    ldout(cct, 10) << "_readdir_prefetch " << dirp << " got " << r
+		   << ", " << dirp->prefetch.result.size() << " entries" << dendl;
+  }
+  dirp->prefetching = false;
+  dirp->prefetch_cond.Signal();
+}
+
+void Client::_readdir_drop_prefetch(dir_result_t *dirp)
+{
+  assert(!dirp->prefetching);
+  for (unsigned i = 0; i < dirp->prefetch.result.size(); i++)
+    put_inode(dirp->prefetch.result[i].second);
+  dirp->prefetch.result.clear();
+  dirp->prefetch.valid = false;
+}
+
 int Client::_readdir_cache_cb(dir_result_t *dirp, add_dirent_cb_t cb, void *p)
 {
   assert(client_lock.is_locked());
@@ -6905,22 +7008,27 @@ int Client::uninline_data(Inode *in, Context *onfinish)
 
 int Client::read(int fd, char *buf, loff_t size, loff_t offset)
 {
-  Mutex::Locker lock(client_lock);
-  tout(cct) << "read" << std::endl;
-  tout(cct) << fd << std::endl;
-  tout(cct) << size << std::endl;
-  tout(cct) << offset << std::endl;
-
-  Fh *f = get_filehandle(fd);
-  if (!f)
-    return -EBADF;
+  bufferlist bl;
+  int r;
+  {
+    Mutex::Locker lock(client_lock);
+    tout(cct) << "read" << std::endl;
+    tout(cct) << fd << std::endl;
+    tout(cct) << size << std::endl;
+    tout(cct) << offset << std::endl;
+
+    Fh *f = get_filehandle(fd);
+    if (!f)
+      return -EBADF;
 #if defined(__linux__) && defined(O_PATH)
-  if (f->flags & O_PATH)
-    return -EBADF;
+    if (f->flags & O_PATH)
+      return -EBADF;
 #endif
-  bufferlist bl;
-  int r = _read(f, offset, size, &bl);
-  ldout(cct, 3) << "read(" << fd << ", " << (void*)buf << ", " << size << ", " << offset << ") = " << r << dendl;
+    r = _read(f, offset, size, &bl);
+    ldout(cct, 3) << "read(" << fd << ", " << (void*)buf << ", " << size << ", " << offset << ") = " << r << dendl;
+  }
+
+  // copy out to the caller without holding client_lock
   if (r >= 0) {
     bl.copy(0, bl.length(), buf);
     r = bl.length();
@@ -6943,12 +7051,25 @@ int Client::_read(Fh *f, int64_t offset, uint64_t size, bufferlist *bl)
   }
   loff_t start_pos = offset;
 
+  // access pattern on this handle
+  if ((uint64_t)offset == f->last_read_end)
+    f->nonseq_reads = 0;
+  else
+    f->nonseq_reads++;
+  f->last_read_end = offset + size;
+
+  // random readers gain nothing from the cache (and churn it); read
+  // around it as long as there is nothing dirty it would hide.
+  bool random_reader = conf->client_oc_random_read_bypass > 0 &&
+    f->nonseq_reads >= conf->client_oc_random_read_bypass;
+
   if (in->inline_version == 0) {
     int r = _getattr(in, CEPH_STAT_CAP_INLINE_DATA, -1, -1, true);
     if (r < 0)
       return r;
     assert(in->inline_version > 0);
   }
+  bool inline_fetched = false;
 
 retry:
   int have;
@@ -6963,7 +7084,21 @@ retry:
   Context *onuninline = NULL;
 
   if (in->inline_version < CEPH_INLINE_NONE) {
-    if (!(have & CEPH_CAP_FILE_CACHE)) {
+    if (!(have & CEPH_CAP_FILE_CACHE) && !inline_fetched &&
+	conf->client_inline_read_from_mds) {
+      // we can't trust our copy of the inline data, but rather than
+      // pushing the file out to RADOS just to read it, fetch the current
+      // data from the MDS (its filelock rdlock makes buffering writers
+      // flush first) and serve the read from that.
+      put_cap_ref(in, CEPH_CAP_FILE_RD);
+      have = 0;
+      inline_fetched = true;
+      r = _getattr(in, CEPH_STAT_CAP_INLINE_DATA, -1, -1, true);
+      if (r < 0)
+	goto done;
+      goto retry;
+    }
+    if (!(have & CEPH_CAP_FILE_CACHE) && !inline_fetched) {
       onuninline = new C_SafeCond(&uninline_flock,
                                   &uninline_cond,
                                   &uninline_done,
@@ -6992,6 +7127,7 @@ retry:
   }
 
   if (!conf->client_debug_force_sync_read &&
+      !(random_reader && !in->oset.dirty_or_tx) &&
       (cct->_conf->client_oc && (have & CEPH_CAP_FILE_CACHE))) {
 
     if (f->flags & O_RSYNC) {
@@ -7109,7 +7245,10 @@ int Client::_read_async(Fh *f, uint64_t off, uint64_t len, bufferlist *bl)
     delete onfinish;
   }
 
-  if(conf->client_readahead_max_bytes > 0) {
+  // _create_fh() capped the window by bytes and/or layout periods;
+  // either one enables readahead.
+  if (conf->client_readahead_max_bytes > 0 ||
+      conf->client_readahead_max_periods > 0) {
     pair<uint64_t, uint64_t> readahead_extent = f->readahead.update(off, len, in->size);
     if (readahead_extent.second > 0) {
       ldout(cct, 20) << "readahead " << readahead_extent.first << "~" << readahead_extent.second
@@ -7239,6 +7378,13 @@ void Client::sync_write_commit(Inode *in)
 
 int Client::write(int fd, const char *buf, loff_t size, loff_t offset) 
 {
+  // copy into fresh buffer (since our write may be resub, async); do it
+  // before taking client_lock so writers don't serialize on the memcpy
+  bufferptr bp;
+  if (size > 0) bp = buffer::copy(buf, size);
+  bufferlist bl;
+  bl.push_back(bp);
+
   Mutex::Locker lock(client_lock);
   tout(cct) << "write" << std::endl;
   tout(cct) << fd << std::endl;
@@ -7252,13 +7398,13 @@ int Client::write(int fd, const char *buf, loff_t size, loff_t offset)
   if (fh->flags & O_PATH)
     return -EBADF;
 #endif
-  int r = _write(fh, offset, size, buf);
+  int r = _write(fh, offset, size, bl);
   ldout(cct, 3) << "write(" << fd << ", \"...\", " << size << ", " << offset << ") = " << r << dendl;
   return r;
 }
 
 
-int Client::_write(Fh *f, int64_t offset, uint64_t size, const char *buf)
+int Client::_write(Fh *f, int64_t offset, uint64_t size, bufferlist& bl)
 {
   if ((uint64_t)(offset+size) > mdsmap->get_max_filesize()) //too large!
     return -EFBIG;
@@ -7309,12 +7455,6 @@ int Client::_write(Fh *f, int64_t offset, uint64_t size, const char *buf)
     assert(in->inline_version > 0);
   }
 
-  // copy into fresh buffer (since our write may be resub, async)
-  bufferptr bp;
-  if (size > 0) bp = buffer::copy(buf, size);
-  bufferlist bl;
-  bl.push_back( bp );
-
   utime_t lat;
   uint64_t totalwritten;
   int have;
@@ -9801,16 +9941,18 @@ int Client::ll_read_block(Inode *in, uint64_t blockid,
 			  uint64_t length,
 			  ceph_file_layout* layout)
 {
-  Mutex::Locker lock(client_lock);
   Mutex flock("Client::ll_read_block flock");
   Cond cond;
-  vinodeno_t vino = ll_get_vino(in);
-  object_t oid = file_object_t(vino.ino, blockid);
   int r = 0;
   bool done = false;
   Context *onfinish = new C_SafeCond(&flock, &cond, &done, &r);
   bufferlist bl;
 
+  /* lock just in time */
+  client_lock.Lock();
+  vinodeno_t vino = ll_get_vino(in);
+  object_t oid = file_object_t(vino.ino, blockid);
+
   objecter->read(oid,
 		 object_locator_t(layout->fl_pg_pool),
 		 offset,
@@ -9820,8 +9962,11 @@ int Client::ll_read_block(Inode *in, uint64_t blockid,
 		 CEPH_OSD_FLAG_READ,
 		 onfinish);
 
+  client_lock.Unlock();
+  flock.Lock();
   while (!done)
-      cond.Wait(client_lock);
+    cond.Wait(flock);
+  flock.Unlock();
 
   if (r >= 0) {
       bl.copy(0, bl.length(), buf);
@@ -9934,6 +10079,11 @@ int Client::ll_commit_blocks(Inode *in,
 
 int Client::ll_write(Fh *fh, loff_t off, loff_t len, const char *data)
 {
+  bufferptr bp;
+  if (len > 0) bp = buffer::copy(data, len);
+  bufferlist bl;
+  bl.push_back(bp);
+
   Mutex::Locker lock(client_lock);
   ldout(cct, 3) << "ll_write " << fh << " " << fh->inode->ino << " " << off <<
     "~" << len << dendl;
@@ -9942,7 +10092,7 @@ int Client::ll_write(Fh *fh, loff_t off, loff_t len, const char *data)
   tout(cct) << off << std::endl;
   tout(cct) << len << std::endl;
 
-  int r = _write(fh, off, len, data);
+  int r = _write(fh, off, len, bl);
   ldout(cct, 3) << "ll_write " << fh << " " << off << "~" << len << " = " << r
 		<< dendl;
   return r;
@@ -186,6 +186,25 @@ struct dir_result_t {
 
   string at_cache_name;  // last entry we successfully returned
 
+  // one readdir reply, as requested (req_*) and as returned
+  struct chunk_t {
+    frag_t req_frag;
+    string req_start;
+    uint64_t req_offset;
+    bool valid;
+    frag_t frag;
+    bool end;
+    unsigned num;
+    string last_name;
+    vector<pair<string,Inode*> > result;
+    chunk_t() : req_offset(0), valid(false), end(false), num(0) {}
+  };
+
+  // the chunk after buffer, fetched while the caller consumes buffer
+  chunk_t prefetch;
+  bool prefetching;      // prefetch queued or in flight
+  Cond prefetch_cond;
+
   dir_result_t(Inode *in);
 
   frag_t frag() { return frag_t(offset >> SHIFT); }
@@ -250,6 +269,7 @@ class Client : public Dispatcher {
   Finisher interrupt_finisher;
   Finisher remount_finisher;
   Finisher objecter_finisher;
+  Finisher readdir_prefetcher;
 
   Context *tick_event;
   utime_t last_cap_renew;
@@ -616,6 +636,11 @@ private:
   void _readdir_next_frag(dir_result_t *dirp);
   void _readdir_rechoose_frag(dir_result_t *dirp);
   int _readdir_get_frag(dir_result_t *dirp);
+  int _readdir_request(Inode *diri, dir_result_t::chunk_t *chunk);
+  void _readdir_start_prefetch(dir_result_t *dirp);
+  void _readdir_prefetch(dir_result_t *dirp);
+  void _readdir_drop_prefetch(dir_result_t *dirp);
+  friend class C_Client_ReaddirPrefetch;
   int _readdir_cache_cb(dir_result_t *dirp, add_dirent_cb_t cb, void *p);
   void _closedir(dir_result_t *dirp);
 
@@ -667,7 +692,7 @@ private:
 	      bool *created = NULL, int uid=-1, int gid=-1);
   loff_t _lseek(Fh *fh, loff_t offset, int whence);
   int _read(Fh *fh, int64_t offset, uint64_t size, bufferlist *bl);
-  int _write(Fh *fh, int64_t offset, uint64_t size, const char *buf);
+  int _write(Fh *fh, int64_t offset, uint64_t size, bufferlist& bl);
   int _flush(Fh *fh);
   int _fsync(Fh *fh, bool syncdataonly);
   int _sync_fs();
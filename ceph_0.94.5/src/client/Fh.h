@@ -22,13 +22,16 @@ struct Fh {
   list<Cond*> pos_waiters;   // waiters for pos
 
   Readahead readahead;
+  uint64_t last_read_end;    // where the previous read on this handle stopped
+  int nonseq_reads;          // consecutive reads that didn't start there
 
   // file lock
   ceph_lock_state_t *fcntl_locks;
   ceph_lock_state_t *flock_locks;
 
   Fh() : _ref(1), inode(0), pos(0), mds(0), mode(0), flags(0), pos_locked(false),
-      readahead(), fcntl_locks(NULL), flock_locks(NULL) {}
+      readahead(), last_read_end(0), nonseq_reads(0),
+      fcntl_locks(NULL), flock_locks(NULL) {}
   void get() { ++_ref; }
   int put() { return --_ref; }
 };
@@ -29,6 +29,7 @@ cls_method_handle_t h_rgw_bucket_check_index;
 cls_method_handle_t h_rgw_bucket_rebuild_index;
 cls_method_handle_t h_rgw_bucket_prepare_op;
 cls_method_handle_t h_rgw_bucket_complete_op;
+cls_method_handle_t h_rgw_bucket_complete_op_batch;
 cls_method_handle_t h_rgw_bucket_link_olh;
 cls_method_handle_t h_rgw_bucket_unlink_instance_op;
 cls_method_handle_t h_rgw_bucket_read_olh_log;
@@ -762,34 +763,23 @@ static int read_key_entry(cls_method_context_t hctx, cls_rgw_obj_key& key, strin
   return 0;
 }
 
-int rgw_bucket_complete_op(cls_method_context_t hctx, bufferlist *in, bufferlist *out)
+/*
+ * apply a single complete op against an already loaded bucket header.  The
+ * caller is responsible for writing the header back if *header_dirty is set.
+ */
+static int do_bucket_complete_op(cls_method_context_t hctx, rgw_cls_obj_complete_op& op,
+                                 struct rgw_bucket_dir_header& header, bool *header_dirty)
 {
-  // decode request
-  rgw_cls_obj_complete_op op;
-  bufferlist::iterator iter = in->begin();
-  try {
-    ::decode(op, iter);
-  } catch (buffer::error& err) {
-    CLS_LOG(1, "ERROR: rgw_bucket_complete_op(): failed to decode request\n");
-    return -EINVAL;
-  }
   CLS_LOG(1, "rgw_bucket_complete_op(): request: op=%d name=%s instance=%s ver=%lu:%llu tag=%s\n",
           op.op, op.key.name.c_str(), op.key.instance.c_str(),
           (unsigned long)op.ver.pool, (unsigned long long)op.ver.epoch,
           op.tag.c_str());
 
-  struct rgw_bucket_dir_header header;
-  int rc = read_bucket_header(hctx, &header);
-  if (rc < 0) {
-    CLS_LOG(1, "ERROR: rgw_bucket_complete_op(): failed to read header\n");
-    return -EINVAL;
-  }
-
   struct rgw_bucket_dir_entry entry;
   bool ondisk = true;
 
   string idx;
-  rc = read_key_entry(hctx, op.key, &idx, &entry);
+  int rc = read_key_entry(hctx, op.key, &idx, &entry);
   if (rc == -ENOENT) {
     entry.key = op.key;
     entry.ver = op.ver;
@@ -842,6 +832,8 @@ int rgw_bucket_complete_op(cls_method_context_t hctx, bufferlist *in, bufferlist
     }
   }
 
+  *header_dirty = true;
+
   if (entry.exists) {
     unaccount_entry(header, entry);
   }
@@ -925,6 +917,96 @@ int rgw_bucket_complete_op(cls_method_context_t hctx, bufferlist *in, bufferlist
     }
   }
 
+  return 0;
+}
+
+int rgw_bucket_complete_op(cls_method_context_t hctx, bufferlist *in, bufferlist *out)
+{
+  // decode request
+  rgw_cls_obj_complete_op op;
+  bufferlist::iterator iter = in->begin();
+  try {
+    ::decode(op, iter);
+  } catch (buffer::error& err) {
+    CLS_LOG(1, "ERROR: rgw_bucket_complete_op(): failed to decode request\n");
+    return -EINVAL;
+  }
+
+  struct rgw_bucket_dir_header header;
+  int rc = read_bucket_header(hctx, &header);
+  if (rc < 0) {
+    CLS_LOG(1, "ERROR: rgw_bucket_complete_op(): failed to read header\n");
+    return -EINVAL;
+  }
+
+  bool header_dirty = false;
+  rc = do_bucket_complete_op(hctx, op, header, &header_dirty);
+  if (rc < 0)
+    return rc;
+
+  if (!header_dirty)
+    return 0;
+
+  return write_bucket_header(hctx, &header);
+}
+
+/*
+ * apply many complete ops in one omap transaction, reading and writing the
+ * bucket header only once.  Entries that can't be applied (e.g., the pending
+ * tag is already gone) are skipped; the pending state they leave behind is
+ * reconciled later through dir_suggest_changes.  Omap reads don't observe
+ * writes made earlier in the same transaction, so the caller must not put
+ * two ops on the same key into one batch.
+ */
+int rgw_bucket_complete_op_batch(cls_method_context_t hctx, bufferlist *in, bufferlist *out)
+{
+  // decode request
+  rgw_cls_obj_complete_op_batch batch;
+  bufferlist::iterator iter = in->begin();
+  try {
+    ::decode(batch, iter);
+  } catch (buffer::error& err) {
+    CLS_LOG(1, "ERROR: rgw_bucket_complete_op_batch(): failed to decode request\n");
+    return -EINVAL;
+  }
+
+  CLS_LOG(10, "rgw_bucket_complete_op_batch(): %d ops\n", (int)batch.ops.size());
+
+  struct rgw_bucket_dir_header header;
+  int rc = read_bucket_header(hctx, &header);
+  if (rc < 0) {
+    CLS_LOG(1, "ERROR: rgw_bucket_complete_op_batch(): failed to read header\n");
+    return -EINVAL;
+  }
+
+  bool header_dirty = false;
+  bool applied = false;
+  for (list<rgw_cls_obj_complete_op>::iterator op_iter = batch.ops.begin();
+       op_iter != batch.ops.end(); ++op_iter) {
+    /*
+     * the bilog key is derived from header.ver, and the cls version and
+     * subop num don't change within this call.  give every op its own
+     * index version, as if each had been a separate complete_op call.
+     */
+    if (applied) {
+      header.ver++;
+      header_dirty = true;
+      applied = false;
+    }
+    rc = do_bucket_complete_op(hctx, *op_iter, header, &header_dirty);
+    if (rc == -EINVAL || rc == -ENOENT) {
+      CLS_LOG(1, "rgw_bucket_complete_op_batch(): skipping op on name=%s instance=%s tag=%s rc=%d\n",
+              op_iter->key.name.c_str(), op_iter->key.instance.c_str(), op_iter->tag.c_str(), rc);
+      continue;
+    }
+    if (rc < 0)
+      return rc;
+    applied = true;
+  }
+
+  if (!header_dirty)
+    return 0;
+
   return write_bucket_header(hctx, &header);
 }
 
@@ -2954,22 +3036,39 @@ static int gc_iterate_entries(cls_method_context_t hctx, const string& marker, b
   return 0;
 }
 
+struct gc_list_state {
+  list<cls_rgw_gc_obj_info> *entries;
+  string last_key;
+};
+
 static int gc_list_cb(cls_method_context_t hctx, const string& key, cls_rgw_gc_obj_info& info, void *param)
 {
-  list<cls_rgw_gc_obj_info> *l = (list<cls_rgw_gc_obj_info> *)param;
-  l->push_back(info);
+  gc_list_state *state = (gc_list_state *)param;
+  state->entries->push_back(info);
+  state->last_key = key;
   return 0;
 }
 
 static int gc_list_entries(cls_method_context_t hctx, const string& marker,
 			   uint32_t max, bool expired_only,
-                           list<cls_rgw_gc_obj_info>& entries, bool *truncated)
+                           list<cls_rgw_gc_obj_info>& entries, bool *truncated,
+                           string *next_marker)
 {
   string key_iter;
+  gc_list_state state;
+  state.entries = &entries;
   int ret = gc_iterate_entries(hctx, marker, expired_only,
                               key_iter, max, truncated,
-                              gc_list_cb, &entries);
-  return ret;
+                              gc_list_cb, &state);
+  if (ret < 0)
+    return ret;
+
+  /* the marker is the time index key without its prefix; listing resumes
+   * after it */
+  const string& prefix = gc_index_prefixes[GC_OBJ_TIME_INDEX];
+  if (state.last_key.size() >= prefix.size())
+    *next_marker = state.last_key.substr(prefix.size());
+  return 0;
 }
 
 static int rgw_cls_gc_list(cls_method_context_t hctx, bufferlist *in, bufferlist *out)
@@ -2985,7 +3084,8 @@ static int rgw_cls_gc_list(cls_method_context_t hctx, bufferlist *in, bufferlist
   }
 
   cls_rgw_gc_list_ret op_ret;
-  int ret = gc_list_entries(hctx, op.marker, op.max, op.expired_only, op_ret.entries, &op_ret.truncated);
+  int ret = gc_list_entries(hctx, op.marker, op.max, op.expired_only, op_ret.entries, &op_ret.truncated,
+                            &op_ret.next_marker);
   if (ret < 0)
     return ret;
 
@@ -3056,6 +3156,7 @@ void __cls_init()
   cls_register_cxx_method(h_class, "bucket_rebuild_index", CLS_METHOD_RD | CLS_METHOD_WR, rgw_bucket_rebuild_index, &h_rgw_bucket_rebuild_index);
   cls_register_cxx_method(h_class, "bucket_prepare_op", CLS_METHOD_RD | CLS_METHOD_WR, rgw_bucket_prepare_op, &h_rgw_bucket_prepare_op);
   cls_register_cxx_method(h_class, "bucket_complete_op", CLS_METHOD_RD | CLS_METHOD_WR, rgw_bucket_complete_op, &h_rgw_bucket_complete_op);
+  cls_register_cxx_method(h_class, "bucket_complete_op_batch", CLS_METHOD_RD | CLS_METHOD_WR, rgw_bucket_complete_op_batch, &h_rgw_bucket_complete_op_batch);
   cls_register_cxx_method(h_class, "bucket_link_olh", CLS_METHOD_RD | CLS_METHOD_WR, rgw_bucket_link_olh, &h_rgw_bucket_link_olh);
   cls_register_cxx_method(h_class, "bucket_unlink_instance", CLS_METHOD_RD | CLS_METHOD_WR, rgw_bucket_unlink_instance, &h_rgw_bucket_unlink_instance_op);
   cls_register_cxx_method(h_class, "bucket_read_olh_log", CLS_METHOD_RD, rgw_bucket_read_olh_log, &h_rgw_bucket_read_olh_log);
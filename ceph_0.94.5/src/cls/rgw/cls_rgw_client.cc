@@ -177,6 +177,16 @@ void cls_rgw_bucket_complete_op(ObjectWriteOperation& o, RGWModifyOp op, string&
   o.exec("rgw", "bucket_complete_op", in);
 }
 
+void cls_rgw_bucket_complete_op_batch(ObjectWriteOperation& o,
+                                      list<rgw_cls_obj_complete_op>& ops)
+{
+  bufferlist in;
+  struct rgw_cls_obj_complete_op_batch call;
+  call.ops = ops;
+  ::encode(call, in);
+  o.exec("rgw", "bucket_complete_op_batch", in);
+}
+
 static bool issue_bucket_list_op(librados::IoCtx& io_ctx,
     const string& oid, const cls_rgw_obj_key& start_obj, const string& filter_prefix,
     uint32_t num_entries, bool list_versions, BucketIndexAioManager *manager,
@@ -591,7 +601,7 @@ void cls_rgw_gc_defer_entry(ObjectWriteOperation& op, uint32_t expiration_secs,
 }
 
 int cls_rgw_gc_list(IoCtx& io_ctx, string& oid, string& marker, uint32_t max, bool expired_only,
-                    list<cls_rgw_gc_obj_info>& entries, bool *truncated)
+                    list<cls_rgw_gc_obj_info>& entries, bool *truncated, string *next_marker)
 {
   bufferlist in, out;
   cls_rgw_gc_list_op call;
@@ -615,6 +625,8 @@ int cls_rgw_gc_list(IoCtx& io_ctx, string& oid, string& marker, uint32_t max, bo
 
   if (truncated)
     *truncated = ret.truncated;
+  if (next_marker)
+    *next_marker = ret.next_marker;
 
  return r;
 }
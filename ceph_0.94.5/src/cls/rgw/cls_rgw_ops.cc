@@ -63,6 +63,7 @@ void cls_rgw_gc_list_op::generate_test_instances(list<cls_rgw_gc_list_op*>& ls)
 void cls_rgw_gc_list_ret::dump(Formatter *f) const
 {
   encode_json("entries", entries, f);
+  f->dump_string("next_marker", next_marker);
   f->dump_int("truncated", (int)truncated);
 }
 
@@ -71,6 +72,7 @@ void cls_rgw_gc_list_ret::generate_test_instances(list<cls_rgw_gc_list_ret*>& ls
   ls.push_back(new cls_rgw_gc_list_ret);
   ls.push_back(new cls_rgw_gc_list_ret);
   ls.back()->entries.push_back(cls_rgw_gc_obj_info());
+  ls.back()->next_marker = "marker";
   ls.back()->truncated = true;
 }
 
@@ -146,6 +148,25 @@ void rgw_cls_obj_complete_op::dump(Formatter *f) const
   f->dump_int("bilog_flags", bilog_flags);
 }
 
+void rgw_cls_obj_complete_op_batch::generate_test_instances(list<rgw_cls_obj_complete_op_batch*>& o)
+{
+  rgw_cls_obj_complete_op_batch *batch = new rgw_cls_obj_complete_op_batch;
+  list<rgw_cls_obj_complete_op *> l;
+  rgw_cls_obj_complete_op::generate_test_instances(l);
+  for (list<rgw_cls_obj_complete_op *>::iterator iter = l.begin(); iter != l.end(); ++iter) {
+    batch->ops.push_back(**iter);
+    delete *iter;
+  }
+  o.push_back(batch);
+
+  o.push_back(new rgw_cls_obj_complete_op_batch);
+}
+
+void rgw_cls_obj_complete_op_batch::dump(Formatter *f) const
+{
+  encode_json("ops", ops, f);
+}
+
 void rgw_cls_link_olh_op::generate_test_instances(list<rgw_cls_link_olh_op*>& o)
 {
   rgw_cls_link_olh_op *op = new rgw_cls_link_olh_op;
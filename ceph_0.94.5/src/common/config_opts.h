@@ -177,6 +177,7 @@ OPTION(mon_compact_on_start, OPT_BOOL, false)  // compact leveldb on ceph-mon st
 OPTION(mon_compact_on_bootstrap, OPT_BOOL, false)  // trigger leveldb compaction on bootstrap
 OPTION(mon_compact_on_trim, OPT_BOOL, true)       // compact (a prefix) when we trim old states
 OPTION(mon_osd_cache_size, OPT_INT, 10)  // the size of osdmaps cache, not to rely on underlying store's cache
+OPTION(mon_osd_client_full_map_gap, OPT_INT, 100) // send clients this many epochs behind the latest full map instead of incrementals; 0 = never
 
 OPTION(mon_tick_interval, OPT_INT, 5)
 OPTION(mon_subscribe_interval, OPT_DOUBLE, 300)
@@ -205,6 +206,7 @@ OPTION(mon_clock_drift_warn_backoff, OPT_FLOAT, 5) // exponential backoff for cl
 OPTION(mon_timecheck_interval, OPT_FLOAT, 300.0) // on leader, timecheck (clock drift check) interval (seconds)
 OPTION(mon_accept_timeout, OPT_FLOAT, 10.0)    // on leader, if paxos update isn't accepted
 OPTION(mon_pg_create_interval, OPT_FLOAT, 30.0) // no more than every 30s
+OPTION(mon_pg_stats_propose_interval, OPT_DOUBLE, 5.0) // commit pure pg/osd stat churn no more often than this; 0 = every paxos_propose_interval
 OPTION(mon_pg_stuck_threshold, OPT_INT, 300) // number of seconds after which pgs can be considered inactive, unclean, or stale (see doc/control.rst under dump_stuck for more info)
 OPTION(mon_pg_warn_min_per_osd, OPT_INT, 30)  // min # pgs per (in) osd before we warn the admin
 OPTION(mon_pg_warn_max_per_osd, OPT_INT, 300)  // max # pgs per (in) osd before we warn the admin
@@ -311,6 +313,8 @@ OPTION(client_readahead_min, OPT_LONGLONG, 128*1024)  // readahead at _least_ th
 OPTION(client_readahead_max_bytes, OPT_LONGLONG, 0)  //8 * 1024*1024
 OPTION(client_readahead_max_periods, OPT_LONGLONG, 4)  // as multiple of file layout period (object size * num stripes)
 OPTION(client_snapdir, OPT_STR, ".snap")
+OPTION(client_readdir_max_bytes, OPT_INT, 0)   // ask the mds for readdir chunks this big; 0 = mds default
+OPTION(client_readdir_prefetch, OPT_BOOL, true) // fetch the next readdir chunk while the caller consumes this one
 OPTION(client_mountpoint, OPT_STR, "/")
 OPTION(client_notify_timeout, OPT_INT, 10) // in seconds
 OPTION(osd_client_watch_timeout, OPT_INT, 30) // in seconds
@@ -323,8 +327,10 @@ OPTION(client_oc_target_dirty, OPT_INT, 1024*1024* 8) // target dirty (keep this
 OPTION(client_oc_max_dirty_age, OPT_DOUBLE, 5.0)      // max age in cache before writeback
 OPTION(client_oc_max_objects, OPT_INT, 1000)      // max objects in cache
 OPTION(client_debug_force_sync_read, OPT_BOOL, false)     // always read synchronously (go to osds)
+OPTION(client_oc_random_read_bypass, OPT_INT, 0) // read around the cache after this many non-sequential reads on a handle; 0 = never
 OPTION(client_debug_inject_tick_delay, OPT_INT, 0) // delay the client tick for a number of seconds
 OPTION(client_max_inline_size, OPT_U64, 4096)
+OPTION(client_inline_read_from_mds, OPT_BOOL, true) // read inline data via getattr instead of uninlining when we lack Fc
 OPTION(client_inject_release_failure, OPT_BOOL, false)  // synthetic client bug for testing
 // note: the max amount of "in flight" dirty data is roughly (max - target)
 OPTION(fuse_use_invalidate_cb, OPT_BOOL, false) // use fuse 2.8+ invalidate callback to keep page cache consistent
@@ -356,10 +362,15 @@ OPTION(journaler_batch_max, OPT_U64, 0)  // max bytes we'll delay flushing; disa
 OPTION(mds_data, OPT_STR, "/var/lib/ceph/mds/$cluster-$id")
 OPTION(mds_max_file_size, OPT_U64, 1ULL << 40)
 OPTION(mds_cache_size, OPT_INT, 100000)
+OPTION(mds_cache_memory_limit, OPT_U64, 0)   // bytes; also trim to this much cached metadata (0 = off)
 OPTION(mds_cache_mid, OPT_FLOAT, .7)
 OPTION(mds_max_file_recover, OPT_U32, 32)
+OPTION(mds_open_file_table, OPT_BOOL, true)  // persist inodes with client caps so a takeover can warm its cache
+OPTION(mds_open_file_table_prefetch_max, OPT_INT, 64) // inodes opened at once from the table during rejoin; 0 = no prefetch
 OPTION(mds_mem_max, OPT_INT, 1048576)        // KB
 OPTION(mds_dir_max_commit_size, OPT_INT, 10) // MB
+OPTION(mds_dir_keys_per_op, OPT_INT, 16384)  // max omap keys per dirfrag/open file table fetch/commit op
+OPTION(mds_dir_prefetch, OPT_BOOL, true)     // fetch the next dirfrag while serving readdir
 OPTION(mds_decay_halflife, OPT_FLOAT, 5)
 OPTION(mds_beacon_interval, OPT_FLOAT, 4)
 OPTION(mds_beacon_grace, OPT_FLOAT, 15)
@@ -381,6 +392,7 @@ OPTION(mds_early_reply, OPT_BOOL, true)
 OPTION(mds_default_dir_hash, OPT_INT, CEPH_STR_HASH_RJENKINS)
 OPTION(mds_log, OPT_BOOL, true)
 OPTION(mds_log_skip_corrupt_events, OPT_BOOL, false)
+OPTION(mds_log_replay_queue_max, OPT_INT, 256) // decoded events queued ahead of replay; 0 = decode and replay inline
 OPTION(mds_log_max_events, OPT_INT, -1)
 OPTION(mds_log_events_per_segment, OPT_INT, 1024)
 OPTION(mds_log_segment_size, OPT_INT, 0)  // segment size for mds log,
@@ -403,7 +415,10 @@ OPTION(mds_bal_fragment_interval, OPT_INT, 5)      // seconds
 OPTION(mds_bal_idle_threshold, OPT_FLOAT, 0)
 OPTION(mds_bal_max, OPT_INT, -1)
 OPTION(mds_bal_max_until, OPT_INT, -1)
-OPTION(mds_bal_mode, OPT_INT, 0)
+OPTION(mds_bal_mode, OPT_INT, 0)             // 0 = meta+req, 1 = req, 2 = cpu, 3 = meta scaled by latency/journal
+OPTION(mds_bal_latency_target, OPT_FLOAT, 20) // ms; mode 3 inflates load when mean reply latency is above this
+OPTION(mds_bal_export_cost, OPT_FLOAT, 0)    // load units charged per inode (rstat) when picking subtrees to export
+OPTION(mds_bal_reexport_interval, OPT_FLOAT, 60) // seconds a freshly imported subtree is left alone
 OPTION(mds_bal_min_rebalance, OPT_FLOAT, .1)  // must be this much above average before we export anything
 OPTION(mds_bal_min_start, OPT_FLOAT, .2)      // if we need less than this, we don't do anything
 OPTION(mds_bal_need_min, OPT_FLOAT, .8)       // take within this range of what we need
@@ -546,6 +561,7 @@ OPTION(osd_tier_default_cache_min_read_recency_for_promote, OPT_INT, 1) // numbe
 OPTION(osd_map_dedup, OPT_BOOL, true)
 OPTION(osd_map_max_advance, OPT_INT, 200) // make this < cache_size!
 OPTION(osd_map_cache_size, OPT_INT, 500)
+OPTION(osd_map_cache_pg_mappings, OPT_BOOL, true) // remember pg up/acting lookups per cached osdmap
 OPTION(osd_map_message_max, OPT_INT, 100)  // max maps per MOSDMap message
 OPTION(osd_map_share_max_epochs, OPT_INT, 100)  // cap on # of inc maps we send to peers, clients
 OPTION(osd_inject_bad_map_crc_probability, OPT_FLOAT, 0)
@@ -940,6 +956,15 @@ OPTION(rgw_override_bucket_index_max_shards, OPT_U32, 0)
  */
 OPTION(rgw_bucket_index_max_aio, OPT_U32, 8)
 
+/**
+ * coalesce bucket index complete ops per index shard over this window and
+ * apply them with a single cls call; 0 disables batching.  Requires osds
+ * that know bucket_complete_op_batch, older ones fall back to single ops.
+ */
+OPTION(rgw_bucket_index_complete_batch_window_ms, OPT_INT, 0)
+OPTION(rgw_bucket_index_complete_batch_max, OPT_INT, 128) // flush a shard's batch early once it holds this many ops
+OPTION(rgw_bucket_index_complete_max_pending, OPT_INT, 1024) // block requests once this many batched ops are not yet applied, 0 for no limit
+
 /**
  * whether or not the quota/gc threads should be started
  */
@@ -950,6 +975,9 @@ OPTION(rgw_data, OPT_STR, "/var/lib/ceph/radosgw/$cluster-$id")
 OPTION(rgw_enable_apis, OPT_STR, "s3, swift, swift_auth, admin")
 OPTION(rgw_cache_enabled, OPT_BOOL, true)   // rgw cache enabled
 OPTION(rgw_cache_lru_size, OPT_INT, 10000)   // num of entries in rgw cache
+OPTION(rgw_cache_shards, OPT_INT, 8)   // num of lock stripes the rgw cache is split into
+OPTION(rgw_cache_max_bytes, OPT_U64, 0)   // max bytes held by rgw cache, 0 for no byte limit
+OPTION(rgw_cache_eviction_policy, OPT_STR, "lru")   // lru or clock
 OPTION(rgw_socket_path, OPT_STR, "")   // path to unix domain socket, if not specified, rgw will not run as external fcgi
 OPTION(rgw_host, OPT_STR, "")  // host for radosgw, can be an IP, default is 0.0.0.0
 OPTION(rgw_port, OPT_STR, "")  // port to listen, format as "8080" "5000", if not specified, rgw will not run external fcgi
@@ -1001,6 +1029,9 @@ OPTION(rgw_ops_log_socket_path, OPT_STR, "") // path to unix domain socket where
 OPTION(rgw_ops_log_data_backlog, OPT_INT, 5 << 20) // max data backlog for ops log
 OPTION(rgw_usage_log_flush_threshold, OPT_INT, 1024) // threshold to flush pending log data
 OPTION(rgw_usage_log_tick_interval, OPT_INT, 30) // flush pending log data every X seconds
+OPTION(rgw_ops_log_flush_interval, OPT_INT, 0) // buffer rados ops log entries and append them every X seconds, 0 to write each entry right away
+OPTION(rgw_ops_log_flush_bytes, OPT_INT, 1 << 20) // flush buffered ops log once this many bytes are pending
+OPTION(rgw_log_buffer_stripes, OPT_INT, 8) // number of lock stripes used by the usage and ops log buffers
 OPTION(rgw_intent_log_object_name, OPT_STR, "%Y-%m-%d-%i-%n")  // man date to see codes (a subset are supported)
 OPTION(rgw_intent_log_object_name_utc, OPT_BOOL, false)
 OPTION(rgw_init_timeout, OPT_INT, 300) // time in seconds
@@ -1009,6 +1040,10 @@ OPTION(rgw_gc_max_objs, OPT_INT, 32)
 OPTION(rgw_gc_obj_min_wait, OPT_INT, 2 * 3600)    // wait time before object may be handled by gc
 OPTION(rgw_gc_processor_max_time, OPT_INT, 3600)  // total run time for a single gc processor work
 OPTION(rgw_gc_processor_period, OPT_INT, 3600)  // gc processor cycle time
+OPTION(rgw_gc_max_concurrent_io, OPT_INT, 10)  // max tail object removals in flight during gc
+OPTION(rgw_gc_max_concurrent_shards, OPT_INT, 4)  // gc shards locked and processed together
+OPTION(rgw_gc_max_trim_chunk, OPT_INT, 16)  // max gc entries trimmed from a shard in one op
+OPTION(rgw_gc_throttle_active_requests, OPT_INT, 0)  // pause gc io while more client requests are active, 0 to disable
 OPTION(rgw_s3_success_create_obj_status, OPT_INT, 0) // alternative success status response for create-obj (0 - default)
 OPTION(rgw_resolve_cname, OPT_BOOL, false)  // should rgw try to resolve hostname as a dns cname record
 OPTION(rgw_obj_stripe_size, OPT_INT, 4 << 20)
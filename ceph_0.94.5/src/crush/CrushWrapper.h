@@ -1031,6 +1031,27 @@ public:
       out[i] = rawout[i];
   }
 
+  /**
+   * map many inputs through the same rule
+   *
+   * Same results as calling do_rule() for each of @p xs, but takes the
+   * mapper lock and sets up the output and scratch space only once.
+   */
+  void do_rule_batch(int rule, const vector<int>& xs, vector<vector<int> >& out,
+		     int maxout, const vector<__u32>& weight) const {
+    Mutex::Locker l(mapper_lock);
+    vector<int> rawout(maxout);
+    vector<int> scratch(maxout * 3);
+    out.resize(xs.size());
+    for (unsigned i = 0; i < xs.size(); ++i) {
+      int numrep = crush_do_rule(crush, rule, xs[i], &rawout[0], maxout,
+				 &weight[0], weight.size(), &scratch[0]);
+      if (numrep < 0)
+	numrep = 0;
+      out[i].assign(rawout.begin(), rawout.begin() + numrep);
+    }
+  }
+
   int read_from_file(const char *fn) {
     bufferlist bl;
     std::string error;
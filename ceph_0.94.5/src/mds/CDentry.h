@@ -181,6 +181,7 @@ public:
     versionlock(this, &versionlock_type) {
     g_num_dn++;
     g_num_dna++;
+    g_dn_name_bytes += name.length();
   }
   CDentry(const std::string& n, __u32 h, inodeno_t ino, unsigned char dt,
 	  snapid_t f, snapid_t l) :
@@ -194,12 +195,14 @@ public:
     versionlock(this, &versionlock_type) {
     g_num_dn++;
     g_num_dna++;
+    g_dn_name_bytes += name.length();
     linkage.remote_ino = ino;
     linkage.remote_d_type = dt;
   }
   ~CDentry() {
     g_num_dn--;
     g_num_dns++;
+    g_dn_name_bytes -= name.length();
   }
 
 
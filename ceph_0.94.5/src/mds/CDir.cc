@@ -1485,7 +1485,7 @@ void CDir::_tmap_fetched(bufferlist& bl, const string& want_dn, int r)
     bl.clear();
   }
 
-  _omap_fetched(header, omap, want_dn, r);
+  _omap_fetched(header, omap, true, want_dn, r);
 }
 
 class C_IO_Dir_OMAP_Fetched : public CDirIOContext {
@@ -1496,26 +1496,30 @@ class C_IO_Dir_OMAP_Fetched : public CDirIOContext {
   map<string, bufferlist> omap;
   bufferlist btbl;
   int ret1, ret2, ret3;
+  unsigned max_keys;
 
-  C_IO_Dir_OMAP_Fetched(CDir *d, const string& w) : CDirIOContext(d), want_dn(w) { }
+  C_IO_Dir_OMAP_Fetched(CDir *d, const string& w, unsigned m) :
+    CDirIOContext(d), want_dn(w), max_keys(m) { }
   void finish(int r) {
     // check the correctness of backtrace
     if (r >= 0 && ret3 != -ECANCELED)
       dir->inode->verify_diri_backtrace(btbl, ret3);
     if (r >= 0) r = ret1;
     if (r >= 0) r = ret2;
-    dir->_omap_fetched(hdrbl, omap, want_dn, r);
+    dir->_omap_fetched(hdrbl, omap, omap.size() < max_keys, want_dn, r);
   }
 };
 
 void CDir::_omap_fetch(const string& want_dn)
 {
-  C_IO_Dir_OMAP_Fetched *fin = new C_IO_Dir_OMAP_Fetched(this, want_dn);
+  unsigned max_keys = g_conf->mds_dir_keys_per_op > 0 ?
+    g_conf->mds_dir_keys_per_op : (unsigned)-1;
+  C_IO_Dir_OMAP_Fetched *fin = new C_IO_Dir_OMAP_Fetched(this, want_dn, max_keys);
   object_t oid = get_ondisk_object();
   object_locator_t oloc(cache->mds->mdsmap->get_metadata_pool());
   ObjectOperation rd;
   rd.omap_get_header(&fin->hdrbl, &fin->ret1);
-  rd.omap_get_vals("", "", (uint64_t)-1, &fin->omap, &fin->ret2);
+  rd.omap_get_vals("", "", max_keys, &fin->omap, &fin->ret2);
   // check the correctness of backtrace
   if (g_conf->mds_verify_backtrace > 0 && frag == frag_t()) {
     rd.getxattr("parent", &fin->btbl, &fin->ret3);
@@ -1528,8 +1532,48 @@ void CDir::_omap_fetch(const string& want_dn)
 			     new C_OnFinisher(fin, &cache->mds->finisher));
 }
 
+class C_IO_Dir_OMAP_FetchedMore : public CDirIOContext {
+ protected:
+  CDir::fetch_progress_t prog;
+  string want_dn;
+ public:
+  map<string, bufferlist> omap;
+  int ret;
+  unsigned max_keys;
+
+  C_IO_Dir_OMAP_FetchedMore(CDir *d, const CDir::fetch_progress_t& p,
+			    const string& w, unsigned m) :
+    CDirIOContext(d), prog(p), want_dn(w), ret(0), max_keys(m) { }
+  void finish(int r) {
+    if (r >= 0) r = ret;
+    dir->_omap_fetched_more(omap, omap.size() < max_keys, prog, want_dn, r);
+  }
+};
+
+/*
+ * Large fragments are read mds_dir_keys_per_op keys at a time. Each page
+ * is loaded into the cache as it arrives, so the OSD op, the reply and the
+ * time spent under mds_lock all stay bounded, and lookups that hit an
+ * already-loaded dentry can proceed while the rest is still being read.
+ */
+void CDir::_omap_fetch_more(const string& start_after, const fetch_progress_t& prog,
+			    const string& want_dn)
+{
+  unsigned max_keys = g_conf->mds_dir_keys_per_op > 0 ?
+    g_conf->mds_dir_keys_per_op : (unsigned)-1;
+  C_IO_Dir_OMAP_FetchedMore *fin = new C_IO_Dir_OMAP_FetchedMore(this, prog, want_dn, max_keys);
+  object_t oid = get_ondisk_object();
+  object_locator_t oloc(cache->mds->mdsmap->get_metadata_pool());
+  ObjectOperation rd;
+  rd.omap_get_vals(start_after, "", max_keys, &fin->omap, &fin->ret);
+
+  dout(10) << "_omap_fetch_more after '" << start_after << "' on " << *this << dendl;
+  cache->mds->objecter->read(oid, oloc, rd, CEPH_NOSNAP, NULL, 0,
+			     new C_OnFinisher(fin, &cache->mds->finisher));
+}
+
 void CDir::_omap_fetched(bufferlist& hdrbl, map<string, bufferlist>& omap,
-			 const string& want_dn, int r)
+			 bool complete, const string& want_dn, int r)
 {
   LogChannelRef clog = cache->mds->clog;
   dout(10) << "_fetched header " << hdrbl.length() << " bytes "
@@ -1588,7 +1632,9 @@ void CDir::_omap_fetched(bufferlist& hdrbl, map<string, bufferlist>& omap,
     }
   }
 
-  list<CInode*> undef_inodes;
+  fetch_progress_t prog;
+  prog.fnode_version = got_fnode.version;
+  prog.check_underwater = (committed_version == 0);
 
   // purge stale snaps?
   // only if we have past_parents open!
@@ -1602,6 +1648,61 @@ void CDir::_omap_fetched(bufferlist& hdrbl, map<string, bufferlist>& omap,
 	     << " < " << realm->get_last_destroyed()
 	     << ", snap purge based on " << *snaps << dendl;
     fnode.snap_purged_thru = realm->get_last_destroyed();
+    prog.purge_snaps = true;
+  }
+
+  _omap_load_dentries(omap, prog, want_dn);
+
+  if (!complete) {
+    _omap_fetch_more(omap.rbegin()->first, prog, want_dn);
+    return;
+  }
+
+  _omap_fetch_finish();
+}
+
+void CDir::_omap_fetched_more(map<string, bufferlist>& omap, bool complete,
+			      const fetch_progress_t& prog, const string& want_dn, int r)
+{
+  dout(10) << "_fetched_more " << omap.size() << " keys for " << *this
+	   << " want_dn=" << want_dn << " r=" << r << dendl;
+
+  assert(r == 0 || r == -ENOENT);
+  assert(is_auth());
+  assert(!is_frozen());
+
+  if (r == -ENOENT) {
+    // the object went away after the first page; treat it like a missing
+    // object there, or waiters would just fetch it again.
+    dout(0) << "_fetched_more missing object for " << *this << dendl;
+    cache->mds->clog->error() << "dir " << dirfrag()
+			      << " object missing on disk; some files may be lost\n";
+    state_set(STATE_BADFRAG);
+    _omap_fetch_finish();
+    return;
+  }
+
+  _omap_load_dentries(omap, prog, want_dn);
+
+  if (!complete && !omap.empty()) {
+    _omap_fetch_more(omap.rbegin()->first, prog, want_dn);
+    return;
+  }
+
+  _omap_fetch_finish();
+}
+
+void CDir::_omap_load_dentries(map<string, bufferlist>& omap,
+			       const fetch_progress_t& prog, const string& want_dn)
+{
+  LogChannelRef clog = cache->mds->clog;
+  list<CInode*> undef_inodes;
+
+  const set<snapid_t> *snaps = NULL;
+  if (prog.purge_snaps) {
+    SnapRealm *realm = inode->find_snaprealm();
+    if (realm->have_past_parents_open())
+      snaps = &realm->get_snaps();
   }
 
   bool stray = inode->is_stray();
@@ -1775,27 +1876,21 @@ void CDir::_omap_fetched(bufferlist& hdrbl, map<string, bufferlist>& omap,
      *   about.  Items that are marked dirty from the journal should be
      *   marked clean if they appear on disk.
      */
-    if (committed_version == 0 &&     
+    if (prog.check_underwater &&
 	dn &&
-	dn->get_version() <= got_fnode.version &&
+	dn->get_version() <= prog.fnode_version &&
 	dn->is_dirty()) {
       dout(10) << "_fetched  had underwater dentry " << *dn << ", marking clean" << dendl;
       dn->mark_clean();
 
       if (dn->get_linkage()->is_primary()) {
-	assert(dn->get_linkage()->get_inode()->get_version() <= got_fnode.version);
+	assert(dn->get_linkage()->get_inode()->get_version() <= prog.fnode_version);
 	dout(10) << "_fetched  had underwater inode " << *dn->get_linkage()->get_inode() << ", marking clean" << dendl;
 	dn->get_linkage()->get_inode()->mark_clean();
       }
     }
   }
 
-  //cache->mds->logger->inc("newin", num_new_inodes_loaded);
-
-  // mark complete, !fetching
-  mark_complete();
-  state_clear(STATE_FETCHING);
-
   // open & force frags
   while (!undef_inodes.empty()) {
     CInode *in = undef_inodes.front();
@@ -1803,6 +1898,18 @@ void CDir::_omap_fetched(bufferlist& hdrbl, map<string, bufferlist>& omap,
     in->state_clear(CInode::STATE_REJOINUNDEF);
     cache->opened_undef_inode(in);
   }
+}
+
+void CDir::_omap_fetch_finish()
+{
+  //cache->mds->logger->inc("newin", num_new_inodes_loaded);
+
+  // MDCache::trim() leaves our dentries alone while STATE_FETCHING is
+  // set, so everything the earlier pages loaded is still here.
+
+  // mark complete, !fetching
+  mark_complete();
+  state_clear(STATE_FETCHING);
 
   auth_unpin(this);
 
@@ -1865,7 +1972,8 @@ public:
 
 /**
  * Flush out the modified dentries in this dir. Keep the bufferlist
- * below max_write_size;
+ * below max_write_size and each op below mds_dir_keys_per_op keys;
+ * the ops are sent together and gathered.
  */
 void CDir::_omap_commit(int op_prio)
 {
@@ -1873,6 +1981,8 @@ void CDir::_omap_commit(int op_prio)
 
   unsigned max_write_size = cache->max_dir_commit_size;
   unsigned write_size = 0;
+  unsigned max_keys = g_conf->mds_dir_keys_per_op > 0 ?
+    g_conf->mds_dir_keys_per_op : (unsigned)-1;
 
   if (op_prio < 0)
     op_prio = CEPH_MSG_PRIO_DEFAULT;
@@ -1933,7 +2043,8 @@ void CDir::_omap_commit(int op_prio)
       to_set[key].swap(dnbl);
     }
 
-    if (write_size >= max_write_size) {
+    if (write_size >= max_write_size ||
+	to_set.size() + to_remove.size() >= max_keys) {
       ObjectOperation op;
       op.priority = op_prio;
 
@@ -287,6 +287,7 @@ protected:
   friend class CDirExport;
   friend class C_IO_Dir_TMAP_Fetched;
   friend class C_IO_Dir_OMAP_Fetched;
+  friend class C_IO_Dir_OMAP_FetchedMore;
   friend class C_IO_Dir_Committed;
 
   bloom_filter *bloom;
@@ -498,9 +499,25 @@ private:
   void fetch(MDSInternalContextBase *c, bool ignore_authpinnability=false);
   void fetch(MDSInternalContextBase *c, const std::string& want_dn, bool ignore_authpinnability=false);
 protected:
+  /* state carried between the pages of a fetch; fixed by the first page
+   * (which also reads the fnode) and applied to every page after it */
+  struct fetch_progress_t {
+    version_t fnode_version;
+    bool check_underwater;
+    bool purge_snaps;
+    fetch_progress_t() : fnode_version(0), check_underwater(false), purge_snaps(false) {}
+  };
+
   void _omap_fetch(const std::string& want_dn);
   void _omap_fetched(bufferlist& hdrbl, std::map<std::string, bufferlist>& omap,
-		     const std::string& want_dn, int r);
+		     bool complete, const std::string& want_dn, int r);
+  void _omap_fetch_more(const std::string& start_after, const fetch_progress_t& prog,
+			const std::string& want_dn);
+  void _omap_fetched_more(std::map<std::string, bufferlist>& omap, bool complete,
+			  const fetch_progress_t& prog, const std::string& want_dn, int r);
+  void _omap_load_dentries(std::map<std::string, bufferlist>& omap,
+			   const fetch_progress_t& prog, const std::string& want_dn);
+  void _omap_fetch_finish();
   void _tmap_fetch(const std::string& want_dn);
   void _tmap_fetched(bufferlist &bl, const std::string& want_dn, int r);
 
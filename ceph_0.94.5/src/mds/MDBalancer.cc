@@ -21,6 +21,7 @@
 #include "CInode.h"
 #include "CDir.h"
 #include "MDCache.h"
+#include "MDLog.h"
 #include "Migrator.h"
 
 #include "include/Context.h"
@@ -136,6 +137,18 @@ double mds_load_t::mds_load()
   case 2:
     return cpu_load_avg;
 
+  case 3:
+    {
+      // metadata load, inflated while replies are slow or the journal
+      // is backing up so busy-but-struggling ranks shed work first
+      double l = .8 * auth.meta_load() + .2 * all.meta_load() + 10.0 * queue_len;
+      if (g_conf->mds_bal_latency_target > 0 &&
+	  req_latency > g_conf->mds_bal_latency_target)
+	l *= req_latency / g_conf->mds_bal_latency_target;
+      if (journal_pressure > 1.0)
+	l *= journal_pressure;
+      return l;
+    }
   }
   assert(0);
   return 0;
@@ -161,6 +174,25 @@ mds_load_t MDBalancer::get_load(utime_t now)
   load.req_rate = mds->get_req_rate();
   load.queue_len = mds->messenger->get_dispatch_queue_len();
 
+  if (mds->logger) {
+    utime_t lat = mds->logger->tget(l_mds_reply_latency);
+    uint64_t count = mds->logger->get(l_mds_reply);
+    if (count > last_reply_count) {
+      last_req_latency = ((double)lat - (double)last_reply_lat) * 1000.0 /
+	(double)(count - last_reply_count);
+      last_reply_lat = lat;
+      last_reply_count = count;
+      last_latency_sample = now;
+    } else if ((double)now - (double)last_latency_sample >
+	       g_conf->mds_bal_sample_interval) {
+      last_req_latency = 0;  // idle
+    }
+    load.req_latency = last_req_latency;
+  }
+  if (g_conf->mds_log_max_segments > 0)
+    load.journal_pressure = (double)mds->mdlog->get_num_segments() /
+      (double)g_conf->mds_log_max_segments;
+
   ifstream cpu("/proc/loadavg");
   if (cpu.is_open())
     cpu >> load.cpu_load_avg;
@@ -606,6 +638,14 @@ void MDBalancer::try_rebalance()
     return;
   }
 
+  for (map<dirfrag_t, utime_t>::iterator p = recent_imports.begin();
+       p != recent_imports.end(); ) {
+    if ((double)rebalance_time - (double)p->second >= g_conf->mds_bal_reexport_interval)
+      recent_imports.erase(p++);
+    else
+      ++p;
+  }
+
   // make a sorted list of my imports
   map<double,CDir*>    import_pop_map;
   multimap<mds_rank_t,CDir*>  import_from_map;
@@ -673,6 +713,10 @@ void MDBalancer::try_rebalance()
 	    dir->inode->is_stray())
 	  continue;
 	if (dir->is_freezing() || dir->is_frozen()) continue;  // export pbly already in progress
+	if (recently_imported(dir, rebalance_time)) {
+	  dout(5) << "not reexporting recent import " << *dir << dendl;
+	  continue;
+	}
 	double pop = dir->pop_auth_subtree.meta_load(rebalance_time, mds->mdcache->decayrate);
 	assert(dir->inode->authority().first == target);  // cuz that's how i put it in the map, dummy
 
@@ -849,10 +893,13 @@ void MDBalancer::find_exports(CDir *dir,
       if (already_exporting.count(subdir)) continue;
 
       if (subdir->is_frozen()) continue;  // can't export this right now!
+      if (recently_imported(subdir, rebalance_time)) continue;
 
       // how popular?
       double pop = subdir->pop_auth_subtree.meta_load(rebalance_time, mds->mdcache->decayrate);
       subdir_sum += pop;
+      // what moving it actually buys us once the migration is paid for
+      pop -= export_cost(subdir);
       dout(15) << "   subdir pop " << pop << " " << *subdir << dendl;
 
       if (pop < minchunk) continue;
@@ -1105,10 +1152,32 @@ void MDBalancer::subtract_export(CDir *dir, utime_t now)
 }
 
 
+bool MDBalancer::recently_imported(CDir *dir, utime_t now)
+{
+  map<dirfrag_t, utime_t>::iterator p = recent_imports.find(dir->dirfrag());
+  if (p == recent_imports.end())
+    return false;
+  return (double)now - (double)p->second < g_conf->mds_bal_reexport_interval;
+}
+
+/*
+ * rough price of migrating a subtree, in load units: everything under
+ * it has to be frozen, encoded, journaled and shipped.
+ */
+double MDBalancer::export_cost(CDir *dir)
+{
+  if (g_conf->mds_bal_export_cost <= 0)
+    return 0;
+  return g_conf->mds_bal_export_cost * (double)dir->fnode.rstat.rsize();
+}
+
 void MDBalancer::add_import(CDir *dir, utime_t now)
 {
   dirfrag_load_vec_t subload = dir->pop_auth_subtree;
 
+  if (g_conf->mds_bal_reexport_interval > 0)
+    recent_imports[dir->dirfrag()] = now;
+
   while (true) {
     dir = dir->inode->get_parent_dir();
     if (!dir) break;
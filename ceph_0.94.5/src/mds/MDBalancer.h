@@ -63,6 +63,17 @@ class MDBalancer {
   map<mds_rank_t, int> old_prev_targets;  // # iterations they _haven't_ been targets
   bool check_targets();
 
+  // subtrees we imported lately; left alone so they don't ping-pong
+  map<dirfrag_t, utime_t> recent_imports;
+  bool recently_imported(CDir *dir, utime_t now);
+  double export_cost(CDir *dir);
+
+  // reply latency totals as of the last latency sample
+  utime_t last_reply_lat;
+  uint64_t last_reply_count;
+  utime_t last_latency_sample;
+  double last_req_latency;
+
   double try_match(mds_rank_t ex, double& maxex,
                    mds_rank_t im, double& maxim);
   double get_maxim(mds_rank_t im) {
@@ -76,7 +87,8 @@ public:
   MDBalancer(MDS *m) : 
     mds(m),
     beat_epoch(0),
-    last_epoch_under(0), last_epoch_over(0), my_load(0.0), target_load(0.0) { }
+    last_epoch_under(0), last_epoch_over(0), my_load(0.0), target_load(0.0),
+    last_reply_count(0), last_req_latency(0.0) { }
   
   mds_load_t get_load(utime_t);
 
@@ -126,6 +126,8 @@ long g_num_dirs = 0;
 long g_num_dns = 0;
 long g_num_caps = 0;
 
+long g_dn_name_bytes = 0;
+
 set<int> SimpleLock::empty_gather_set;
 
 
@@ -171,6 +173,7 @@ MDCache::MDCache(MDS *m) :
   num_strays(0),
   num_strays_purging(0),
   num_strays_delayed(0),
+  open_file_table(m),
   recovery_queue(m),
   delayed_eval_stray(member_offset(CDentry, item_stray))
 {
@@ -3736,6 +3739,7 @@ void MDCache::rejoin_start()
   // need finish opening cap inodes before sending cache rejoins
   rejoin_gather.insert(mds->get_nodeid());
   process_imported_caps();
+  open_file_table.prefetch_inodes();
 }
 
 /*
@@ -6092,6 +6096,14 @@ void MDCache::start_recovered_truncates()
  * however, we may expire a replica whose authority is recovering.
  * 
  */
+uint64_t MDCache::get_cache_bytes() const
+{
+  return (uint64_t)g_num_ino * sizeof(CInode) +
+    (uint64_t)g_num_dir * sizeof(CDir) +
+    (uint64_t)g_num_dn * sizeof(CDentry) + g_dn_name_bytes +
+    (uint64_t)g_num_cap * sizeof(Capability);
+}
+
 bool MDCache::trim(int max, int count)
 {
   // trim LRU
@@ -6101,6 +6113,19 @@ bool MDCache::trim(int max, int count)
       max = 1;
   } else if (max < 0) {
     max = g_conf->mds_cache_size;
+
+    // over the memory limit?  shrink the dentry target in proportion,
+    // using the average footprint per cached dentry.
+    uint64_t limit = g_conf->mds_cache_memory_limit;
+    uint64_t bytes = get_cache_bytes();
+    if (limit > 0 && bytes > limit && lru.lru_get_size() > 0) {
+      uint64_t per_dn = MAX(1, bytes / lru.lru_get_size());
+      int by_bytes = MAX(1, limit / per_dn);
+      dout(7) << "trim cache " << bytes << " bytes > limit " << limit
+	      << ", ~" << per_dn << " bytes/dentry, target " << by_bytes << dendl;
+      if (max <= 0 || by_bytes < max)
+	max = by_bytes;
+    }
     if (max <= 0)
       return false;
   }
@@ -6124,8 +6149,11 @@ bool MDCache::trim(int max, int count)
   while (lru.lru_get_size() + unexpirable > (unsigned)max) {
     CDentry *dn = static_cast<CDentry*>(lru.lru_expire());
     if (!dn) break;
+    // dentries loaded by earlier pages of a paged fetch stay until the
+    // fetch finishes, or the dir could never be marked complete.
     if ((is_standby_replay && dn->get_linkage()->inode &&
         dn->get_linkage()->inode->item_open_file.is_on_list()) ||
+	dn->get_dir()->state_test(CDir::STATE_FETCHING) ||
 	trim_dentry(dn, expiremap)) {
       unexpirables.push_back(dn);
       ++unexpirable;
@@ -7022,11 +7050,19 @@ void MDCache::check_memory_usage()
       mds->server->recall_client_state(ratio);
   } else 
     */
-  if (num_inodes_with_caps > g_conf->mds_cache_size) {
-    float ratio = (float)g_conf->mds_cache_size * .9 / (float)num_inodes_with_caps;
-    if (ratio < 1.0)
-      mds->server->recall_client_state(ratio);
-  }
+  float ratio = 1.0;
+  if (num_inodes_with_caps > g_conf->mds_cache_size)
+    ratio = (float)g_conf->mds_cache_size * .9 / (float)num_inodes_with_caps;
+
+  // inodes pinned by client caps can't be trimmed; if we are over the
+  // memory limit, ask clients to give some back.
+  uint64_t limit = g_conf->mds_cache_memory_limit;
+  uint64_t bytes = get_cache_bytes();
+  if (limit > 0 && bytes > limit)
+    ratio = MIN(ratio, (float)limit * .9 / (float)bytes);
+
+  if (ratio < 1.0)
+    mds->server->recall_client_state(ratio);
 
 }
 
@@ -8321,6 +8357,14 @@ void MDCache::open_ino(inodeno_t ino, int64_t pool, MDSInternalContextBase* fin,
     info.tid = ++open_ino_last_tid;
     info.pool = pool >= 0 ? pool : default_file_layout.fl_pg_pool;
     info.waiters.push_back(fin);
+    if (open_file_table.get_ancestors(ino, info.ancestors)) {
+      // the previous holder of this rank had it open; go straight there
+      dout(10) << " open file table hint " << info.ancestors << dendl;
+      info.check_peers = false;
+      info.fetch_backtrace = false;
+      _open_ino_traverse_dir(ino, info, 0);
+      return;
+    }
     do_open_ino(ino, info, 0);
   }
 }
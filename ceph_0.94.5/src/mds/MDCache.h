@@ -27,6 +27,7 @@
 #include "include/Context.h"
 #include "events/EMetaBlob.h"
 #include "RecoveryQueue.h"
+#include "OpenFileTable.h"
 #include "MDSContext.h"
 
 #include "messages/MClientRequest.h"
@@ -569,6 +570,8 @@ public:
   friend class Migrator;
   friend class MDBalancer;
 
+  // inodes with client caps, persisted to warm a takeover's cache
+  OpenFileTable open_file_table;
 
   // File size recovery
 private:
@@ -597,6 +600,8 @@ public:
   // cache
   void set_cache_size(size_t max) { lru.lru_set_max(max); }
   size_t get_cache_size() { return lru.lru_get_size(); }
+  // estimated bytes held by cached inodes, dirfrags, dentries and caps
+  uint64_t get_cache_bytes() const;
 
   // trimming
   bool trim(int max=-1, int count=-1);   // trim cache
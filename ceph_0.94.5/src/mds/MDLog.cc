@@ -1090,6 +1090,11 @@ void MDLog::_replay_thread()
 {
   dout(10) << "_replay_thread start" << dendl;
 
+  if (g_conf->mds_log_replay_queue_max > 0) {
+    replay_queue_stop = false;
+    replay_apply_thread.create();
+  }
+
   // loop
   int r = 0;
   while (1) {
@@ -1120,6 +1125,7 @@ void MDLog::_replay_thread()
            * the MDS is going to either shut down or restart when
            * we return this error, doing it synchronously is fine
            * -- as long as we drop the main mds lock--. */
+          _replay_queue_drain();
           C_SaferCond reread_fin;
           journaler->reread_head(&reread_fin);
           int err = reread_fin.wait();
@@ -1173,41 +1179,25 @@ void MDLog::_replay_thread()
     }
     le->set_start_off(pos);
 
-    // new segment?
-    if (le->get_type() == EVENT_SUBTREEMAP ||
-	le->get_type() == EVENT_RESETJOURNAL) {
-      ESubtreeMap *sle = dynamic_cast<ESubtreeMap*>(le);
-      if (sle && sle->event_seq > 0)
-	event_seq = sle->event_seq;
-      else
-	event_seq = pos;
-      segments[event_seq] = new LogSegment(event_seq, pos);
-      logger->set(l_mdl_seg, segments.size());
-    } else {
-      event_seq++;
-    }
-
-    // have we seen an import map yet?
-    if (segments.empty()) {
-      dout(10) << "_replay " << pos << "~" << bl.length() << " / " << journaler->get_write_pos() 
-	       << " " << le->get_stamp() << " -- waiting for subtree_map.  (skipping " << *le << ")" << dendl;
+    if (replay_apply_thread.is_started()) {
+      _replay_queue_event(le, pos, journaler->get_read_pos());
     } else {
-      dout(10) << "_replay " << pos << "~" << bl.length() << " / " << journaler->get_write_pos() 
-	       << " " << le->get_stamp() << ": " << *le << dendl;
-      le->_segment = get_current_segment();    // replay may need this
-      le->_segment->num_events++;
-      le->_segment->end = journaler->get_read_pos();
-      num_events++;
-
       mds->mds_lock.Lock();
-      le->replay(mds);
+      _replay_one(le, pos, journaler->get_read_pos());
       mds->mds_lock.Unlock();
     }
-    delete le;
 
     logger->set(l_mdl_rdpos, pos);
   }
 
+  if (replay_apply_thread.is_started()) {
+    replay_queue_lock.Lock();
+    replay_queue_stop = true;
+    replay_queue_cond.SignalAll();
+    replay_queue_lock.Unlock();
+    replay_apply_thread.join();
+  }
+
   // done!
   if (r == 0) {
     assert(journaler->get_read_pos() == journaler->get_write_pos());
@@ -1225,6 +1215,104 @@ void MDLog::_replay_thread()
   dout(10) << "_replay_thread finish" << dendl;
 }
 
+/*
+ * Segment bookkeeping and replay for one decoded event; takes ownership
+ * of le.  Called with mds_lock held.
+ */
+void MDLog::_replay_one(LogEvent *le, uint64_t pos, uint64_t end)
+{
+  assert(mds->mds_lock.is_locked_by_me());
+
+  // new segment?
+  if (le->get_type() == EVENT_SUBTREEMAP ||
+      le->get_type() == EVENT_RESETJOURNAL) {
+    ESubtreeMap *sle = dynamic_cast<ESubtreeMap*>(le);
+    if (sle && sle->event_seq > 0)
+      event_seq = sle->event_seq;
+    else
+      event_seq = pos;
+    segments[event_seq] = new LogSegment(event_seq, pos);
+    logger->set(l_mdl_seg, segments.size());
+  } else {
+    event_seq++;
+  }
+
+  // have we seen an import map yet?
+  if (segments.empty()) {
+    dout(10) << "_replay " << pos << "~" << (end - pos) << " / " << journaler->get_write_pos() 
+	     << " " << le->get_stamp() << " -- waiting for subtree_map.  (skipping " << *le << ")" << dendl;
+  } else {
+    dout(10) << "_replay " << pos << "~" << (end - pos) << " / " << journaler->get_write_pos() 
+	     << " " << le->get_stamp() << ": " << *le << dendl;
+    le->_segment = get_current_segment();    // replay may need this
+    le->_segment->num_events++;
+    le->_segment->end = end;
+    num_events++;
+
+    le->replay(mds);
+  }
+  delete le;
+}
+
+void MDLog::_replay_queue_event(LogEvent *le, uint64_t pos, uint64_t end)
+{
+  Mutex::Locker l(replay_queue_lock);
+  while (replay_queue_len >= (unsigned)g_conf->mds_log_replay_queue_max)
+    replay_queue_cond.Wait(replay_queue_lock);
+  replay_queue.push_back(ReplayItem(le, pos, end));
+  replay_queue_len++;
+  replay_queue_cond.SignalAll();
+}
+
+/*
+ * Wait until everything decoded so far has been replayed; the read side
+ * must do this before touching segments itself.
+ */
+void MDLog::_replay_queue_drain()
+{
+  if (!replay_apply_thread.is_started())
+    return;
+  Mutex::Locker l(replay_queue_lock);
+  while (replay_queue_len > 0 || replay_applying)
+    replay_queue_cond.Wait(replay_queue_lock);
+}
+
+void MDLog::_replay_apply_thread()
+{
+  dout(10) << "_replay_apply_thread start" << dendl;
+
+  replay_queue_lock.Lock();
+  while (true) {
+    if (replay_queue.empty()) {
+      if (replay_queue_stop)
+	break;
+      replay_queue_cond.Wait(replay_queue_lock);
+      continue;
+    }
+
+    // take everything decoded so far; one mds_lock round trip per batch
+    list<ReplayItem> batch;
+    batch.swap(replay_queue);
+    replay_queue_len = 0;
+    replay_applying = true;
+    replay_queue_cond.SignalAll();
+    replay_queue_lock.Unlock();
+
+    dout(20) << "_replay_apply_thread replaying " << batch.size() << " events" << dendl;
+    mds->mds_lock.Lock();
+    for (list<ReplayItem>::iterator p = batch.begin(); p != batch.end(); ++p)
+      _replay_one(p->le, p->pos, p->end);
+    mds->mds_lock.Unlock();
+
+    replay_queue_lock.Lock();
+    replay_applying = false;
+    replay_queue_cond.SignalAll();
+  }
+  replay_queue_lock.Unlock();
+
+  dout(10) << "_replay_apply_thread finish" << dendl;
+}
+
 void MDLog::standby_trim_segments()
 {
   dout(10) << "standby_trim_segments" << dendl;
@@ -100,6 +100,36 @@ protected:
   void _replay();         // old way
   void _replay_thread();  // new way
 
+  // replay pipeline: _replay_thread reads and decodes events while the
+  // apply thread replays the ones already decoded under mds_lock.
+  struct ReplayItem {
+    LogEvent *le;
+    uint64_t pos, end;
+    ReplayItem(LogEvent *e, uint64_t p, uint64_t n) : le(e), pos(p), end(n) {}
+  };
+  Mutex replay_queue_lock;
+  Cond replay_queue_cond;
+  list<ReplayItem> replay_queue;
+  unsigned replay_queue_len;
+  bool replay_queue_stop;
+  bool replay_applying;
+
+  class ReplayApplyThread : public Thread {
+    MDLog *log;
+  public:
+    ReplayApplyThread(MDLog *l) : log(l) {}
+    void* entry() {
+      log->_replay_apply_thread();
+      return 0;
+    }
+  } replay_apply_thread;
+  friend class ReplayApplyThread;
+
+  void _replay_apply_thread();
+  void _replay_one(LogEvent *le, uint64_t pos, uint64_t end);
+  void _replay_queue_event(LogEvent *le, uint64_t pos, uint64_t end);
+  void _replay_queue_drain();
+
   // Journal recovery/rewrite logic
   class RecoveryThread : public Thread {
     MDLog *log;
@@ -188,6 +218,11 @@ public:
 		  logger(0),
 		  replay_thread(this),
 		  already_replayed(false),
+		  replay_queue_lock("MDLog::replay_queue_lock"),
+		  replay_queue_len(0),
+		  replay_queue_stop(false),
+		  replay_applying(false),
+		  replay_apply_thread(this),
 		  recovery_thread(this),
 		  event_seq(0), expiring_events(0), expired_events(0),
 		  submit_mutex("MDLog::submit_mutex"),
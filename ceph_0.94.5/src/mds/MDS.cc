@@ -733,6 +733,8 @@ void MDS::create_logger()
     mds_plb.add_u64_counter(l_mds_exported_inodes, "exported_inodes");
     mds_plb.add_u64_counter(l_mds_imported, "imported");
     mds_plb.add_u64_counter(l_mds_imported_inodes, "imported_inodes");
+    mds_plb.add_time_avg(l_mds_dispatch_lock_wait, "dispatch_lock_wait");
+    mds_plb.add_time_avg(l_mds_dispatch_lock_hold, "dispatch_lock_hold");
     logger = mds_plb.create_perf_counters();
     g_ceph_context->get_perfcounters_collection()->add(logger);
   }
@@ -755,6 +757,11 @@ void MDS::create_logger()
     mdm_plb.add_u64(l_mdm_heap, "heap");
     mdm_plb.add_u64(l_mdm_malloc, "malloc");
     mdm_plb.add_u64(l_mdm_buf, "buf");
+    mdm_plb.add_u64(l_mdm_ino_bytes, "ino_bytes");
+    mdm_plb.add_u64(l_mdm_dir_bytes, "dir_bytes");
+    mdm_plb.add_u64(l_mdm_dn_bytes, "dn_bytes");
+    mdm_plb.add_u64(l_mdm_cap_bytes, "cap_bytes");
+    mdm_plb.add_u64(l_mdm_cache_bytes, "cache_bytes");
     mlogger = mdm_plb.create_perf_counters();
     g_ceph_context->get_perfcounters_collection()->add(mlogger);
   }
@@ -1086,6 +1093,7 @@ void MDS::tick()
     mdcache->trim_client_leases();
     mdcache->check_memory_usage();
     mdlog->trim();  // NOT during recovery!
+    mdcache->open_file_table.commit();
   }
 
   // log
@@ -1102,6 +1110,14 @@ void MDS::tick()
     mdcache->log_stat();
   }
 
+  if (mlogger) {
+    mlogger->set(l_mdm_ino_bytes, g_num_ino * sizeof(CInode));
+    mlogger->set(l_mdm_dir_bytes, g_num_dir * sizeof(CDir));
+    mlogger->set(l_mdm_dn_bytes, g_num_dn * sizeof(CDentry) + g_dn_name_bytes);
+    mlogger->set(l_mdm_cap_bytes, g_num_cap * sizeof(Capability));
+    mlogger->set(l_mdm_cache_bytes, mdcache->get_cache_bytes());
+  }
+
   // ...
   if (is_clientreplay() || is_active() || is_stopping()) {
     locker->tick();
@@ -2177,6 +2193,7 @@ void MDS::reconnect_start()
   if (last_state == MDSMap::STATE_REPLAY)
     reopen_log();
 
+  mdcache->open_file_table.load();
   server->reconnect_clients();
   finish_contexts(g_ceph_context, waiting_for_reconnect);
 }
@@ -2236,6 +2253,7 @@ void MDS::active_start()
     mdcache->open_root();
 
   mdcache->clean_open_file_lists();
+  mdcache->open_file_table.mark_all_dirty();
   mdcache->export_remaining_imported_caps();
   finish_contexts(g_ceph_context, waiting_for_replay);  // kick waiters
   finish_contexts(g_ceph_context, waiting_for_active);  // kick waiters
@@ -2432,10 +2450,27 @@ void MDS::handle_write_error(int err)
   }
 }
 
+void MDS::ms_fast_preprocess(Message *m)
+{
+  switch (m->get_type()) {
+  case CEPH_MSG_CLIENT_REQUEST:
+    {
+      // split the request paths into components now; filepath caches
+      // them, so path_traverse() does not pay for it under mds_lock.
+      MClientRequest *req = static_cast<MClientRequest*>(m);
+      req->get_filepath().depth();
+      req->get_filepath2().depth();
+    }
+    break;
+  }
+}
+
 bool MDS::ms_dispatch(Message *m)
 {
   bool ret;
+  utime_t start = ceph_clock_now(g_ceph_context);
   mds_lock.Lock();
+  utime_t locked = ceph_clock_now(g_ceph_context);
 
   heartbeat_reset();
 
@@ -2448,6 +2483,10 @@ bool MDS::ms_dispatch(Message *m)
     ret = _dispatch(m);
     dec_dispatch_depth();
   }
+  if (logger) {
+    logger->tinc(l_mds_dispatch_lock_wait, locked - start);
+    logger->tinc(l_mds_dispatch_lock_hold, ceph_clock_now(g_ceph_context) - locked);
+  }
   mds_lock.Unlock();
   return ret;
 }
@@ -73,6 +73,8 @@ enum {
   l_mds_exported_inodes,
   l_mds_imported,
   l_mds_imported_inodes,
+  l_mds_dispatch_lock_wait,
+  l_mds_dispatch_lock_hold,
   l_mds_last,
 };
 
@@ -95,6 +97,11 @@ enum {
   l_mdm_heap,
   l_mdm_malloc,
   l_mdm_buf,
+  l_mdm_ino_bytes,
+  l_mdm_dir_bytes,
+  l_mdm_dn_bytes,
+  l_mdm_cap_bytes,
+  l_mdm_cache_bytes,
   l_mdm_last,
 };
 
@@ -316,6 +323,12 @@ public:
  private:
   int dispatch_depth;
   bool ms_dispatch(Message *m);
+  // we never fast dispatch, but want ms_fast_preprocess() so that
+  // per-message work that needs no cache state runs in the messenger's
+  // reader threads instead of under mds_lock.
+  bool ms_can_fast_dispatch_any() const { return true; }
+  bool ms_can_fast_dispatch(Message *m) const { return false; }
+  void ms_fast_preprocess(Message *m);
   bool ms_get_authorizer(int dest_type, AuthAuthorizer **authorizer, bool force_new);
   bool ms_verify_authorizer(Connection *con, int peer_type,
 			       int protocol, bufferlist& authorizer_data, bufferlist& authorizer_reply,
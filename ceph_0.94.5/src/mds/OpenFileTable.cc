@@ -0,0 +1,351 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+/*
+ * Ceph - scalable distributed file system
+ *
+ * Copyright (C) 2004-2006 Sage Weil <sage@newdream.net>
+ *
+ * This is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1, as published by the Free Software
+ * Foundation.  See file COPYING.
+ *
+ */
+
+#include "CInode.h"
+#include "MDCache.h"
+#include "MDS.h"
+#include "osdc/Objecter.h"
+
+#include "common/config.h"
+#include "common/Finisher.h"
+
+#include "OpenFileTable.h"
+
+
+#define dout_subsys ceph_subsys_mds
+#undef dout_prefix
+#define dout_prefix *_dout << "mds." << mds->get_nodeid() << " OpenFileTable::" << __func__ << " "
+
+class OpenFileTableIOContext : public MDSIOContextBase {
+protected:
+  OpenFileTable *oft;
+  MDS *get_mds() { return oft->mds; }
+public:
+  OpenFileTableIOContext(OpenFileTable *o) : oft(o) {
+    assert(oft != NULL);
+  }
+};
+
+class C_IO_OFT_Committed : public OpenFileTableIOContext {
+public:
+  C_IO_OFT_Committed(OpenFileTable *o) : OpenFileTableIOContext(o) {}
+  void finish(int r) {
+    oft->_committed(r);
+  }
+};
+
+class C_IO_OFT_Load : public OpenFileTableIOContext {
+public:
+  std::map<std::string, bufferlist> vals;
+  int ret;
+  C_IO_OFT_Load(OpenFileTable *o) : OpenFileTableIOContext(o), ret(0) {}
+  void finish(int r) {
+    oft->_loaded(r < 0 ? r : ret, vals);
+  }
+};
+
+class C_OFT_Prefetched : public MDSInternalContextBase {
+  OpenFileTable *oft;
+  inodeno_t ino;
+  MDS *get_mds() { return oft->mds; }
+public:
+  C_OFT_Prefetched(OpenFileTable *o, inodeno_t i) : oft(o), ino(i) {}
+  void finish(int r) {
+    oft->_prefetched(ino, r);
+  }
+};
+
+
+object_t OpenFileTable::get_object_name()
+{
+  char n[50];
+  snprintf(n, sizeof(n), "mds%d_openfiles", int(mds->whoami));
+  return object_t(n);
+}
+
+void OpenFileTable::add_inode(CInode *in)
+{
+  if (!g_conf->mds_open_file_table)
+    return;
+  dout(20) << *in << dendl;
+  anchor_map[in->ino()] = in;
+  dirty_items.insert(in->ino());
+}
+
+void OpenFileTable::remove_inode(CInode *in)
+{
+  if (!anchor_map.erase(in->ino()))
+    return;
+  dout(20) << *in << dendl;
+  dirty_items.insert(in->ino());
+}
+
+/**
+ * We don't know which entries the previous holder of this rank left
+ * behind that no client reconnected, so once active, replace the whole
+ * object with what we have now.
+ */
+void OpenFileTable::mark_all_dirty()
+{
+  if (!g_conf->mds_open_file_table)
+    return;
+  dout(10) << anchor_map.size() << " items" << dendl;
+  clear_on_commit = true;
+  dirty_items.clear();
+}
+
+void OpenFileTable::_encode_item(CInode *in, std::map<std::string, bufferlist>& to_set)
+{
+  inode_backtrace_t bt;
+  in->build_backtrace(mds->mdsmap->get_metadata_pool(), bt);
+  if (bt.ancestors.empty())
+    return;  // base inodes are always in cache
+
+  char key[32];
+  snprintf(key, sizeof(key), "%llx", (unsigned long long)in->ino().val);
+  bufferlist& bl = to_set[key];
+  ENCODE_START(1, 1, bl);
+  ::encode(bt.ancestors, bl);
+  ENCODE_FINISH(bl);
+}
+
+void OpenFileTable::commit()
+{
+  if (committing) {
+    dout(10) << "still committing, waiting" << dendl;
+    return;
+  }
+  if (!clear_on_commit && dirty_items.empty())
+    return;
+
+  dout(10) << (clear_on_commit ? "rewriting " : "updating ")
+	   << (clear_on_commit ? anchor_map.size() : dirty_items.size())
+	   << " items" << dendl;
+
+  committing = true;
+
+  C_GatherBuilder gather(g_ceph_context,
+			 new C_OnFinisher(new C_IO_OFT_Committed(this),
+					  &mds->finisher));
+  SnapContext snapc;
+  object_t oid = get_object_name();
+  object_locator_t oloc(mds->mdsmap->get_metadata_pool());
+  const unsigned max_keys = MAX(g_conf->mds_dir_keys_per_op, 1);
+
+  std::map<std::string, bufferlist> to_set;
+  std::set<std::string> to_remove;
+  bool clear = clear_on_commit;
+
+  std::map<inodeno_t, CInode*>::iterator a = anchor_map.begin();
+  std::set<inodeno_t>::iterator d = dirty_items.begin();
+  while (true) {
+    if (clear_on_commit) {
+      if (a == anchor_map.end())
+	break;
+      _encode_item(a->second, to_set);
+      ++a;
+    } else {
+      if (d == dirty_items.end())
+	break;
+      std::map<inodeno_t, CInode*>::iterator q = anchor_map.find(*d);
+      if (q != anchor_map.end()) {
+	_encode_item(q->second, to_set);
+      } else {
+	char key[32];
+	snprintf(key, sizeof(key), "%llx", (unsigned long long)d->val);
+	to_remove.insert(key);
+      }
+      ++d;
+    }
+
+    if (to_set.size() + to_remove.size() >= max_keys) {
+      ObjectOperation op;
+      op.create(false);
+      if (clear) {
+	op.omap_clear();
+	clear = false;
+      }
+      if (!to_set.empty())
+	op.omap_set(to_set);
+      if (!to_remove.empty())
+	op.omap_rm_keys(to_remove);
+      mds->objecter->mutate(oid, oloc, op, snapc, ceph_clock_now(g_ceph_context),
+			    0, NULL, gather.new_sub());
+      to_set.clear();
+      to_remove.clear();
+    }
+  }
+
+  if (clear || !to_set.empty() || !to_remove.empty()) {
+    ObjectOperation op;
+    op.create(false);
+    if (clear)
+      op.omap_clear();
+    if (!to_set.empty())
+      op.omap_set(to_set);
+    if (!to_remove.empty())
+      op.omap_rm_keys(to_remove);
+    mds->objecter->mutate(oid, oloc, op, snapc, ceph_clock_now(g_ceph_context),
+			  0, NULL, gather.new_sub());
+  }
+
+  clear_on_commit = false;
+  dirty_items.clear();
+
+  if (gather.has_subs())
+    gather.activate();
+  else
+    committing = false;  // nothing but base inodes; the context is dropped
+}
+
+void OpenFileTable::_committed(int r)
+{
+  dout(10) << "r = " << r << dendl;
+  committing = false;
+  if (r < 0) {
+    mds->clog->error() << "failed to store open file table object,"
+		       << " errno " << r << "\n";
+    mds->handle_write_error(r);
+    // we don't know what made it; rewrite everything next time
+    clear_on_commit = true;
+    dirty_items.clear();
+  }
+}
+
+void OpenFileTable::load()
+{
+  if (!g_conf->mds_open_file_table || loading || load_done)
+    return;
+  dout(10) << dendl;
+  loading = true;
+  _load_more(std::string());
+}
+
+void OpenFileTable::_load_more(const std::string& start_after)
+{
+  C_IO_OFT_Load *c = new C_IO_OFT_Load(this);
+  object_t oid = get_object_name();
+  object_locator_t oloc(mds->mdsmap->get_metadata_pool());
+  ObjectOperation rd;
+  rd.omap_get_vals(start_after, "", MAX(g_conf->mds_dir_keys_per_op, 1),
+		   &c->vals, &c->ret);
+  mds->objecter->read(oid, oloc, rd, CEPH_NOSNAP, NULL, 0,
+		      new C_OnFinisher(c, &mds->finisher));
+}
+
+void OpenFileTable::_loaded(int r, std::map<std::string, bufferlist>& vals)
+{
+  if (r == -EBLACKLISTED) {
+    mds->suicide();
+    return;
+  }
+  if (r < 0) {
+    // missing (first takeover) or unreadable; either way we just don't
+    // get any hints.
+    if (r == -ENOENT)
+      dout(10) << "no table to load" << dendl;
+    else
+      dout(0) << "failed to load table, r = " << r << dendl;
+    vals.clear();
+  }
+
+  for (std::map<std::string, bufferlist>::iterator p = vals.begin();
+       p != vals.end();
+       ++p) {
+    inodeno_t ino(strtoull(p->first.c_str(), NULL, 16));
+    std::vector<inode_backpointer_t> ancestors;
+    try {
+      bufferlist::iterator q = p->second.begin();
+      DECODE_START(1, q);
+      ::decode(ancestors, q);
+      DECODE_FINISH(q);
+    } catch (buffer::error& e) {
+      dout(0) << "corrupt entry for " << p->first << ", ignoring" << dendl;
+      continue;
+    }
+    if (ino != inodeno_t(0) && !ancestors.empty())
+      loaded_anchors[ino].swap(ancestors);
+  }
+
+  if (r >= 0 && vals.size() >= (unsigned)MAX(g_conf->mds_dir_keys_per_op, 1)) {
+    _load_more(vals.rbegin()->first);
+    return;
+  }
+
+  dout(10) << "loaded " << loaded_anchors.size() << " items" << dendl;
+  loading = false;
+  load_done = true;
+
+  // rejoin may have started while we were reading
+  if (mds->is_rejoin() || mds->is_clientreplay() || mds->is_active())
+    prefetch_inodes();
+}
+
+bool OpenFileTable::get_ancestors(inodeno_t ino,
+				  std::vector<inode_backpointer_t>& ancestors)
+{
+  std::map<inodeno_t, std::vector<inode_backpointer_t> >::iterator p =
+    loaded_anchors.find(ino);
+  if (p == loaded_anchors.end())
+    return false;
+  ancestors = p->second;
+  return true;
+}
+
+void OpenFileTable::prefetch_inodes()
+{
+  if (!load_done || prefetch_started)
+    return;
+  prefetch_started = true;
+
+  if (g_conf->mds_open_file_table_prefetch_max > 0) {
+    for (std::map<inodeno_t, std::vector<inode_backpointer_t> >::iterator p =
+	   loaded_anchors.begin();
+	 p != loaded_anchors.end();
+	 ++p) {
+      if (!mds->mdcache->get_inode(p->first))
+	prefetch_queue.push_back(p->first);
+    }
+  }
+  dout(10) << prefetch_queue.size() << " of " << loaded_anchors.size()
+	   << " items not in cache" << dendl;
+  _prefetch_advance();
+}
+
+void OpenFileTable::_prefetch_advance()
+{
+  while (!prefetch_queue.empty() &&
+	 num_prefetching < (unsigned)g_conf->mds_open_file_table_prefetch_max) {
+    inodeno_t ino = prefetch_queue.front();
+    prefetch_queue.pop_front();
+    if (mds->mdcache->get_inode(ino))
+      continue;
+    dout(20) << "opening " << ino << dendl;
+    num_prefetching++;
+    mds->mdcache->open_ino(ino, (int64_t)-1, new C_OFT_Prefetched(this, ino), false);
+  }
+
+  if (prefetch_queue.empty() && num_prefetching == 0 && !loaded_anchors.empty()) {
+    dout(10) << "done, dropping " << loaded_anchors.size() << " loaded items" << dendl;
+    loaded_anchors.clear();
+  }
+}
+
+void OpenFileTable::_prefetched(inodeno_t ino, int r)
+{
+  dout(20) << ino << " r = " << r << dendl;
+  assert(num_prefetching > 0);
+  num_prefetching--;
+  _prefetch_advance();
+}
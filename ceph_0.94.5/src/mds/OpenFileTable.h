@@ -0,0 +1,88 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+/*
+ * Ceph - scalable distributed file system
+ *
+ * Copyright (C) 2004-2006 Sage Weil <sage@newdream.net>
+ *
+ * This is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1, as published by the Free Software
+ * Foundation.  See file COPYING.
+ *
+ */
+
+#ifndef OPEN_FILE_TABLE_H
+#define OPEN_FILE_TABLE_H
+
+#include <list>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "mdstypes.h"
+#include "inode_backtrace.h"
+
+class CInode;
+class MDS;
+
+/**
+ * Per-rank record of the inodes that clients hold caps on, kept in the
+ * omap of a "mdsN_openfiles" object in the metadata pool.  Each entry
+ * maps an ino to the ancestors it had when it entered the table.
+ *
+ * An MDS taking over a rank loads the table while clients reconnect.
+ * The stored ancestors let open_ino() walk straight down the tree
+ * instead of asking peers and reading backtraces, and the inodes that
+ * are still missing at rejoin are prefetched so the cache is warm
+ * before client requests start arriving.  Entries are only hints: a
+ * stale one just falls back to the normal open_ino() path.
+ */
+class OpenFileTable {
+public:
+  OpenFileTable(MDS *mds_) : mds(mds_), clear_on_commit(false),
+			     committing(false), loading(false),
+			     load_done(false), prefetch_started(false),
+			     num_prefetching(0) {}
+
+  void add_inode(CInode *in);     ///< inode got its first client cap
+  void remove_inode(CInode *in);  ///< inode dropped its last client cap
+  void mark_all_dirty();          ///< rewrite the whole object on next commit
+  void commit();                  ///< write out dirty entries (if any)
+
+  void load();                    ///< read the table left by the previous holder
+  bool get_ancestors(inodeno_t ino, std::vector<inode_backpointer_t>& ancestors);
+  void prefetch_inodes();         ///< open loaded inodes that are not in cache
+
+private:
+  object_t get_object_name();
+  void _encode_item(CInode *in, std::map<std::string, bufferlist>& to_set);
+  void _committed(int r);
+  void _load_more(const std::string& start_after);
+  void _loaded(int r, std::map<std::string, bufferlist>& vals);
+  void _prefetch_advance();
+  void _prefetched(inodeno_t ino, int r);
+
+  MDS *mds;
+
+  std::map<inodeno_t, CInode*> anchor_map;  ///< inodes with client caps
+  std::set<inodeno_t> dirty_items;          ///< added/removed since last commit
+  bool clear_on_commit;
+  bool committing;
+
+  std::map<inodeno_t, std::vector<inode_backpointer_t> > loaded_anchors;
+  bool loading;
+  bool load_done;
+
+  bool prefetch_started;
+  std::list<inodeno_t> prefetch_queue;
+  unsigned num_prefetching;
+
+  friend class OpenFileTableIOContext;
+  friend class C_OFT_Prefetched;
+  friend class C_IO_OFT_Committed;
+  friend class C_IO_OFT_Load;
+};
+
+#endif // OPEN_FILE_TABLE_H
@@ -2544,6 +2544,31 @@ CDir* Server::try_open_auth_dirfrag(CInode *diri, frag_t fg, MDRequestRef& mdr)
   return dir;
 }
 
+/*
+ * Start loading the fragment a readdir will move on to next, so that it
+ * is (or is on its way to being) in cache by the time the client asks.
+ */
+void Server::prefetch_next_dirfrag(CInode *diri, frag_t fg)
+{
+  if (fg.is_rightmost())
+    return;
+  frag_t nextfg = diri->dirfragtree[fg.next().value()];
+
+  CDir *dir = diri->get_dirfrag(nextfg);
+  if (!dir) {
+    if (!diri->is_auth() || diri->is_frozen())
+      return;
+    dir = diri->get_or_open_dirfrag(mdcache, nextfg);
+  }
+
+  if (!dir->is_auth() || dir->is_complete() ||
+      dir->state_test(CDir::STATE_FETCHING) || !dir->can_auth_pin())
+    return;
+
+  dout(10) << "prefetch_next_dirfrag " << *dir << dendl;
+  dir->fetch(NULL);
+}
+
 
 // ===============================================================================
 // STAT
@@ -3258,6 +3283,10 @@ void Server::handle_client_readdir(MDRequestRef& mdr)
 
   // bump popularity.  NOTE: this doesn't quite capture it.
   mds->balancer->hit_dir(ceph_clock_now(g_ceph_context), dir, META_POP_IRD, -1, numfiles);
+
+  // the client moves on to the next fragment after this one
+  if (end && g_conf->mds_dir_prefetch)
+    prefetch_next_dirfrag(diri, dir->get_frag());
   
   // reply
   mdr->tracei = diri;
@@ -156,6 +156,7 @@ public:
 				    ceph_file_layout **layout=NULL);
 
   CDir* try_open_auth_dirfrag(CInode *diri, frag_t fg, MDRequestRef& mdr);
+  void prefetch_next_dirfrag(CInode *diri, frag_t fg);
 
 
   // requests on existing inodes.
@@ -80,6 +80,7 @@ extern const mds_rank_t MDS_RANK_NONE;
 extern long g_num_ino, g_num_dir, g_num_dn, g_num_cap;
 extern long g_num_inoa, g_num_dira, g_num_dna, g_num_capa;
 extern long g_num_inos, g_num_dirs, g_num_dns, g_num_caps;
+extern long g_dn_name_bytes;
 
 
 // CAPS
@@ -1042,14 +1043,18 @@ struct mds_load_t {
 
   double cpu_load_avg;
 
+  double req_latency;       // mean reply latency since last sample (ms)
+  double journal_pressure;  // log segments / mds_log_max_segments
+
   mds_load_t(const utime_t &t) : 
     auth(t), all(t), req_rate(0), cache_hit_rate(0),
-    queue_len(0), cpu_load_avg(0)
+    queue_len(0), cpu_load_avg(0), req_latency(0), journal_pressure(0)
   {}
   // mostly for the dencoder infrastructure
   mds_load_t() :
     auth(), all(),
-    req_rate(0), cache_hit_rate(0), queue_len(0), cpu_load_avg(0)
+    req_rate(0), cache_hit_rate(0), queue_len(0), cpu_load_avg(0),
+    req_latency(0), journal_pressure(0)
   {}
   
   double mds_load();  // defiend in MDBalancer.cc
@@ -1072,6 +1077,8 @@ inline std::ostream& operator<<( std::ostream& out, mds_load_t& load )
              << ", hr " << load.cache_hit_rate
              << ", qlen " << load.queue_len
 	     << ", cpu " << load.cpu_load_avg
+	     << ", lat " << load.req_latency
+	     << ", jp " << load.journal_pressure
              << ">";
 }
 
@@ -545,6 +545,8 @@ int Monitor::preinit()
     pcb.add_u64_counter(l_mon_election_call, "election_call");
     pcb.add_u64_counter(l_mon_election_win, "election_win");
     pcb.add_u64_counter(l_mon_election_lose, "election_lose");
+    pcb.add_u64_counter(l_mon_osdmap_cache_hit, "osdmap_cache_hit");   // encoded osdmap epochs served from cache
+    pcb.add_u64_counter(l_mon_osdmap_cache_miss, "osdmap_cache_miss"); // ... read from the store
     logger = pcb.create_perf_counters();
     cct->get_perfcounters_collection()->add(logger);
   }
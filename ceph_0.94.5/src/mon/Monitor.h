@@ -97,6 +97,8 @@ enum {
   l_mon_election_call,
   l_mon_election_win,
   l_mon_election_lose,
+  l_mon_osdmap_cache_hit,
+  l_mon_osdmap_cache_miss,
   l_mon_last,
 };
 
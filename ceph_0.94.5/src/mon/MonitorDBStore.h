@@ -15,6 +15,7 @@
 
 #include "include/types.h"
 #include "include/buffer.h"
+#include "include/stringify.h"
 #include <set>
 #include <map>
 #include <string>
@@ -141,6 +142,29 @@ class MonitorDBStore
       ops.push_back(Op(OP_COMPACT, prefix, start, end));
     }
 
+    /**
+     * compact the keys for versions [first, last] (optionally with
+     * key_prefix in front, e.g. "full_").  versions are stored as decimal
+     * strings, so they do not sort numerically; split the range at each
+     * change in the number of digits so every piece is a valid key range.
+     */
+    void compact_version_range(string prefix, version_t first, version_t last,
+			       const string& key_prefix = string()) {
+      while (first <= last) {
+	version_t band_end = 9;
+	while (band_end < first && band_end <= ((version_t)-1 - 9) / 10)
+	  band_end = band_end * 10 + 9;
+	version_t end = last;
+	if (band_end >= first)  // else first has the most digits there are
+	  end = MIN(last, band_end);
+	compact_range(prefix, key_prefix + stringify(first),
+		      key_prefix + stringify(end));
+	if (end == last)
+	  break;
+	first = end + 1;
+      }
+    }
+
     void encode(bufferlist& bl) const {
       ENCODE_START(2, 1, bl);
       ::encode(ops, bl);
@@ -251,6 +251,9 @@ void OSDMonitor::update_from_paxos(bool *need_bootstrap)
     } else {
       assert(!inc.have_crc);
       put_version_full(t, osdmap.epoch, full_bl);
+      // every subscriber is about to ask for this one; share the
+      // encoding we already have rather than reading it back.
+      full_osd_cache.add(osdmap.epoch, full_bl);
     }
     put_version_latest_full(t, osdmap.epoch);
 
@@ -2220,6 +2223,24 @@ void OSDMonitor::send_incremental(epoch_t first, MonSession *session,
   dout(5) << "send_incremental [" << first << ".." << osdmap.get_epoch() << "]"
 	  << " to " << session->inst << dendl;
 
+  // A client only needs the current map, not the history (unlike osds,
+  // which need it for peering).  When one is far behind, e.g. after an
+  // outage when everyone reconnects, one full map (usually straight from
+  // full_osd_cache) is far cheaper than walking every incremental.  We
+  // advertise it as the oldest map so the Objecter jumps to it instead
+  // of asking for the epochs in between.
+  if (g_conf->mon_osd_client_full_map_gap > 0 &&
+      session->inst.name.is_client() &&
+      first + g_conf->mon_osd_client_full_map_gap <= osdmap.get_epoch()) {
+    dout(10) << __func__ << " client is "
+	     << (osdmap.get_epoch() - first + 1)
+	     << " epochs behind, sending latest full map" << dendl;
+    MOSDMap *m = build_latest_full();
+    m->oldest_map = osdmap.get_epoch();
+    session->con->send_message(m);
+    return;
+  }
+
   if (first < get_first_committed()) {
     first = get_first_committed();
     bufferlist bl;
@@ -2255,8 +2276,10 @@ void OSDMonitor::send_incremental(epoch_t first, MonSession *session,
 int OSDMonitor::get_version(version_t ver, bufferlist& bl)
 {
     if (inc_osd_cache.lookup(ver, &bl)) {
+      mon->logger->inc(l_mon_osdmap_cache_hit);
       return 0;
     }
+    mon->logger->inc(l_mon_osdmap_cache_miss);
     int ret = PaxosService::get_version(ver, bl);
     if (!ret) {
       inc_osd_cache.add(ver, bl);
@@ -2267,8 +2290,10 @@ int OSDMonitor::get_version(version_t ver, bufferlist& bl)
 int OSDMonitor::get_version_full(version_t ver, bufferlist& bl)
 {
     if (full_osd_cache.lookup(ver, &bl)) {
+      mon->logger->inc(l_mon_osdmap_cache_hit);
       return 0;
     }
+    mon->logger->inc(l_mon_osdmap_cache_miss);
     int ret = PaxosService::get_version_full(ver, bl);
     if (!ret) {
       full_osd_cache.add(ver, bl);
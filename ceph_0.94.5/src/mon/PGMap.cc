@@ -373,7 +373,7 @@ void PGMap::calc_stats()
 
   redo_full_sets();
 
-  calc_min_last_epoch_clean();
+  min_last_epoch_clean = 0;  // recalculated on demand
 }
 
 void PGMap::update_pg(pg_t pgid, bufferlist& bl)
@@ -856,6 +856,24 @@ void PGMap::get_stuck_stats(int types, utime_t cutoff,
 			    ceph::unordered_map<pg_t, pg_stat_t>& stuck_pgs) const
 {
   assert(types != 0);
+
+  // num_pg_by_state tells us whether any pg can possibly match without
+  // walking all of them; on a healthy cluster nothing does.
+  bool any = false;
+  for (ceph::unordered_map<int,int>::const_iterator p = num_pg_by_state.begin();
+       p != num_pg_by_state.end() && !any;
+       ++p) {
+    int state = p->first;
+    if (((types & STUCK_INACTIVE) && !(state & PG_STATE_ACTIVE)) ||
+	((types & STUCK_UNCLEAN) && !(state & PG_STATE_CLEAN)) ||
+	((types & STUCK_DEGRADED) && (state & PG_STATE_DEGRADED)) ||
+	((types & STUCK_UNDERSIZED) && (state & PG_STATE_UNDERSIZED)) ||
+	((types & STUCK_STALE) && (state & PG_STATE_STALE)))
+      any = true;
+  }
+  if (!any)
+    return;
+
   for (ceph::unordered_map<pg_t, pg_stat_t>::const_iterator i = pg_stat.begin();
        i != pg_stat.end();
        ++i) {
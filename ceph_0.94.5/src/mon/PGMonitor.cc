@@ -690,6 +690,77 @@ bool PGMonitor::preprocess_getpoolstats(MGetPoolStats *m)
 }
 
 
+static int nearfull_state(const osd_stat_t& s, float full, float nearfull)
+{
+  if (s.kb == 0)
+    return 0;
+  float ratio = ((float)s.kb_used) / ((float)s.kb);
+  if (full > 0 && ratio > full)
+    return 2;
+  if (nearfull > 0 && ratio > nearfull)
+    return 1;
+  return 0;
+}
+
+bool PGMonitor::pending_is_stat_only() const
+{
+  if (!pending_inc.pg_remove.empty() ||
+      !pending_inc.get_osd_stat_rm().empty() ||
+      pending_inc.osdmap_epoch ||
+      pending_inc.pg_scan ||
+      pending_inc.full_ratio != pg_map.full_ratio ||
+      pending_inc.nearfull_ratio != pg_map.nearfull_ratio)
+    return false;
+
+  for (map<pg_t,pg_stat_t>::const_iterator p = pending_inc.pg_stat_updates.begin();
+       p != pending_inc.pg_stat_updates.end();
+       ++p) {
+    ceph::unordered_map<pg_t,pg_stat_t>::const_iterator q = pg_map.pg_stat.find(p->first);
+    if (q == pg_map.pg_stat.end() ||
+	q->second.state != p->second.state ||
+	q->second.up != p->second.up ||
+	q->second.acting != p->second.acting)
+      return false;
+  }
+
+  const map<int32_t,osd_stat_t>& osd_updates = pending_inc.get_osd_stat_updates();
+  for (map<int32_t,osd_stat_t>::const_iterator p = osd_updates.begin();
+       p != osd_updates.end();
+       ++p) {
+    ceph::unordered_map<int32_t,osd_stat_t>::const_iterator q = pg_map.osd_stat.find(p->first);
+    if (q == pg_map.osd_stat.end() ||
+	nearfull_state(q->second, pg_map.full_ratio, pg_map.nearfull_ratio) !=
+	nearfull_state(p->second, pg_map.full_ratio, pg_map.nearfull_ratio))
+      return false;
+  }
+  return true;
+}
+
+bool PGMonitor::should_propose(double& delay)
+{
+  if (!PaxosService::should_propose(delay))
+    return false;
+
+  // Every osd reports every few seconds, so on a large cluster there is
+  // nearly always something pending.  Committing pure counter churn at
+  // paxos_propose_interval costs the leader (and every peon) an encode,
+  // a store write and an apply each time; batch it up instead.  Anything
+  // that changes a pg or osd state still goes out at the normal rate.
+  if (g_conf->mon_pg_stats_propose_interval > 0 &&
+      get_last_committed() > 1 &&
+      pending_is_stat_only()) {
+    utime_t next = pg_map.stamp;
+    next += g_conf->mon_pg_stats_propose_interval;
+    double wait = next - ceph_clock_now(g_ceph_context);
+    if (wait > delay) {
+      dout(10) << __func__ << " only stat updates pending, delaying "
+	       << wait << "s" << dendl;
+      delay = wait;
+    }
+  }
+  return true;
+}
+
 bool PGMonitor::preprocess_pg_stats(MPGStats *stats)
 {
   // check caps
@@ -77,6 +77,14 @@ private:
   bool preprocess_query(PaxosServiceMessage *m);  // true if processed.
   bool prepare_update(PaxosServiceMessage *m);
 
+  bool should_propose(double &delay);
+  /**
+   * check whether pending_inc only moves counters around
+   *
+   * @return true if no pg or osd changes state, appears or goes away
+   */
+  bool pending_is_stat_only() const;
+
   bool preprocess_pg_stats(MPGStats *stats);
   bool pg_stats_have_changed(int from, const MPGStats *stats) const;
   bool prepare_pg_stats(MPGStats *stats);
@@ -647,6 +647,27 @@ void Paxos::begin(bufferlist& v)
   f.flush(*_dout);
   *_dout << dendl;
 
+  // ask others to accept it too!  we do this before writing the value
+  // ourselves so that our write overlaps the round trip and the peons'
+  // writes.  that is safe: accepts are handled under mon->lock, so we
+  // won't see (and commit on) any of them until our write is done.
+  if (mon->get_quorum().size() > 1) {
+    for (set<int>::const_iterator p = mon->get_quorum().begin();
+	 p != mon->get_quorum().end();
+	 ++p) {
+      if (*p == mon->rank) continue;
+
+      dout(10) << " sending begin to mon." << *p << dendl;
+      MMonPaxos *begin = new MMonPaxos(mon->get_epoch(), MMonPaxos::OP_BEGIN,
+				       ceph_clock_now(g_ceph_context));
+      begin->values[last_committed+1] = new_value;
+      begin->last_committed = last_committed;
+      begin->pn = accepted_pn;
+
+      mon->messenger->send_message(begin, mon->monmap->get_inst(*p));
+    }
+  }
+
   logger->inc(l_paxos_begin);
   logger->inc(l_paxos_begin_keys, t->get_keys());
   logger->inc(l_paxos_begin_bytes, t->get_bytes());
@@ -665,22 +686,6 @@ void Paxos::begin(bufferlist& v)
     return;
   }
 
-  // ask others to accept it too!
-  for (set<int>::const_iterator p = mon->get_quorum().begin();
-       p != mon->get_quorum().end();
-       ++p) {
-    if (*p == mon->rank) continue;
-    
-    dout(10) << " sending begin to mon." << *p << dendl;
-    MMonPaxos *begin = new MMonPaxos(mon->get_epoch(), MMonPaxos::OP_BEGIN,
-				     ceph_clock_now(g_ceph_context));
-    begin->values[last_committed+1] = new_value;
-    begin->last_committed = last_committed;
-    begin->pn = accepted_pn;
-    
-    mon->messenger->send_message(begin, mon->monmap->get_inst(*p));
-  }
-
   // set timeout event
   accept_timeout_event = new C_AcceptTimeout(this);
   mon->timer.add_event_after(g_conf->mon_accept_timeout, accept_timeout_event);
@@ -1200,7 +1205,7 @@ void Paxos::trim()
   t->put(get_name(), "first_committed", end);
   if (g_conf->mon_compact_on_trim) {
     dout(10) << " compacting trimmed range" << dendl;
-    t->compact_range(get_name(), stringify(first_committed - 1), stringify(end));
+    t->compact_version_range(get_name(), first_committed, end);
   }
 
   trimming = true;
@@ -1481,7 +1486,6 @@ void Paxos::propose_pending()
 
   bufferlist bl;
   pending_proposal->encode(bl);
-  pending_proposal.reset();
 
   dout(10) << __func__ << " " << (last_committed + 1)
 	   << " " << bl.length() << " bytes" << dendl;
@@ -1491,6 +1495,8 @@ void Paxos::propose_pending()
   f.flush(*_dout);
   *_dout << dendl;
 
+  pending_proposal.reset();
+
   committing_finishers.swap(pending_finishers);
   state = STATE_UPDATING;
   begin(bl);
@@ -95,8 +95,17 @@ bool PaxosService::dispatch(PaxosServiceMessage *m)
 	propose_pending();
       } else {
 	// delay a bit
+	utime_t due = ceph_clock_now(g_ceph_context);
+	due += delay;
+	if (proposal_timer && due < proposal_due) {
+	  // an earlier deadline (e.g. a state change behind batched stats)
+	  dout(10) << " pulling proposal_timer " << proposal_timer << " in to " << due << dendl;
+	  mon->timer.cancel_event(proposal_timer);
+	  proposal_timer = 0;
+	}
 	if (!proposal_timer) {
 	  proposal_timer = new C_Propose(this);
+	  proposal_due = due;
 	  dout(10) << " setting proposal_timer " << proposal_timer << " with delay of " << delay << dendl;
 	  mon->timer.add_event_after(delay, proposal_timer);
 	} else { 
@@ -370,6 +379,7 @@ void PaxosService::trim(MonitorDBStore::TransactionRef t,
   dout(10) << __func__ << " from " << from << " to " << to << dendl;
   assert(from != to);
 
+  bool have_full = false;
   for (version_t v = from; v < to; ++v) {
     dout(20) << __func__ << " " << v << dendl;
     t->erase(get_service_name(), v);
@@ -378,11 +388,14 @@ void PaxosService::trim(MonitorDBStore::TransactionRef t,
     if (mon->store->exists(get_service_name(), full_key)) {
       dout(20) << __func__ << " " << full_key << dendl;
       t->erase(get_service_name(), full_key);
+      have_full = true;
     }
   }
   if (g_conf->mon_compact_on_trim) {
     dout(20) << " compacting prefix " << get_service_name() << dendl;
-    t->compact_range(get_service_name(), stringify(from - 1), stringify(to));
+    t->compact_version_range(get_service_name(), from, to);
+    if (have_full)
+      t->compact_version_range(get_service_name(), from, to, "full_");
   }
 }
 
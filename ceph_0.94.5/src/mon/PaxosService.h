@@ -72,6 +72,8 @@ class PaxosService {
    * runs out and fires.
    */
   Context *proposal_timer;
+  /// when proposal_timer is due to fire
+  utime_t proposal_due;
   /**
    * If the implementation class has anything pending to be proposed to Paxos,
    * then have_pending should be true; otherwise, false.
@@ -1090,8 +1090,13 @@ void OSDService::send_incremental_map(epoch_t since, Connection *con,
 bool OSDService::_get_map_bl(epoch_t e, bufferlist& bl)
 {
   bool found = map_bl_cache.lookup(e, &bl);
-  if (found)
+  if (found) {
+    if (logger)
+      logger->inc(l_osd_map_bl_cache_hit);
     return true;
+  }
+  if (logger)
+    logger->inc(l_osd_map_bl_cache_miss);
   found = store->read(
     META_COLL, OSD::get_osdmap_pobject_name(e), 0, 0, bl) >= 0;
   if (found)
@@ -1103,8 +1108,13 @@ bool OSDService::get_inc_map_bl(epoch_t e, bufferlist& bl)
 {
   Mutex::Locker l(map_cache_lock);
   bool found = map_bl_inc_cache.lookup(e, &bl);
-  if (found)
+  if (found) {
+    if (logger)
+      logger->inc(l_osd_map_bl_cache_hit);
     return true;
+  }
+  if (logger)
+    logger->inc(l_osd_map_bl_cache_miss);
   found = store->read(
     META_COLL, OSD::get_inc_osdmap_pobject_name(e), 0, 0, bl) >= 0;
   if (found)
@@ -1154,6 +1164,9 @@ OSDMapRef OSDService::_add_map(OSDMap *o)
       OSDMap::dedup(for_dedup.get(), o);
     }
   }
+  if (cct->_conf->osd_map_cache_pg_mappings)
+    o->enable_pg_mapping_cache();
+
   bool existed;
   OSDMapRef l = map_cache.add(e, o, &existed);
   if (existed) {
@@ -2152,6 +2165,8 @@ void OSD::create_logger()
   osd_plb.add_u64_counter(l_osd_map, "map_messages");           // osdmap messages
   osd_plb.add_u64_counter(l_osd_mape, "map_message_epochs");         // osdmap epochs
   osd_plb.add_u64_counter(l_osd_mape_dup, "map_message_epoch_dups"); // dup osdmap epochs
+  osd_plb.add_u64_counter(l_osd_map_bl_cache_hit, "osd_map_bl_cache_hit");   // encoded osdmaps served from cache
+  osd_plb.add_u64_counter(l_osd_map_bl_cache_miss, "osd_map_bl_cache_miss"); // ... read from the store
   osd_plb.add_u64_counter(l_osd_waiting_for_map,
 			  "messages_delayed_for_map"); // dup osdmap epochs
 
@@ -1255,6 +1255,7 @@ void OSDMap::remove_down_temps(CephContext *cct,
 
 int OSDMap::apply_incremental(const Incremental &inc)
 {
+  pg_mapping_cache.reset();
   new_blacklist_entries = false;
   if (inc.epoch == 1)
     fsid = inc.fsid;
@@ -1693,6 +1694,29 @@ void OSDMap::_pg_to_up_acting_osds(const pg_t& pg, vector<int> *up, int *up_prim
       *acting_primary = -1;
     return;
   }
+
+  // only folded pgids; raw ones (from object_locator_to_pg) would just
+  // fill the cache with aliases
+  PGMappingCache *cache = pg_mapping_cache.get();
+  if (cache && (cache->epoch != epoch || pg.ps() >= pool->get_pg_num()))
+    cache = NULL;
+  if (cache) {
+    Mutex::Locker l(cache->lock);
+    ceph::unordered_map<pg_t, pg_mapping_t>::const_iterator p =
+      cache->mappings.find(pg);
+    if (p != cache->mappings.end()) {
+      if (up)
+	*up = p->second.up;
+      if (up_primary)
+	*up_primary = p->second.up_primary;
+      if (acting)
+	*acting = p->second.acting;
+      if (acting_primary)
+	*acting_primary = p->second.acting_primary;
+      return;
+    }
+  }
+
   vector<int> raw;
   vector<int> _up;
   vector<int> _acting;
@@ -1709,6 +1733,14 @@ void OSDMap::_pg_to_up_acting_osds(const pg_t& pg, vector<int> *up, int *up_prim
       _acting_primary = _up_primary;
     }
   }
+  if (cache) {
+    Mutex::Locker l(cache->lock);
+    pg_mapping_t& m = cache->mappings[pg];
+    m.up = _up;
+    m.up_primary = _up_primary;
+    m.acting = _acting;
+    m.acting_primary = _acting_primary;
+  }
   if (up)
     up->swap(_up);
   if (up_primary)
@@ -1719,6 +1751,46 @@ void OSDMap::_pg_to_up_acting_osds(const pg_t& pg, vector<int> *up, int *up_prim
     *acting_primary = _acting_primary;
 }
 
+void OSDMap::pool_to_acting_osds(int64_t poolid, vector<vector<int> > *acting,
+				 vector<int> *acting_primary) const
+{
+  acting->clear();
+  acting_primary->clear();
+  const pg_pool_t *pool = get_pg_pool(poolid);
+  if (!pool)
+    return;
+
+  unsigned pg_num = pool->get_pg_num();
+  vector<int> pps(pg_num);
+  for (unsigned ps = 0; ps < pg_num; ++ps)
+    pps[ps] = pool->raw_pg_to_pps(pg_t(ps, poolid));
+
+  vector<vector<int> > raw;
+  unsigned size = pool->get_size();
+  int ruleno = crush->find_rule(pool->get_crush_ruleset(), pool->get_type(), size);
+  if (ruleno >= 0)
+    crush->do_rule_batch(ruleno, pps, raw, size, osd_weight);
+  else
+    raw.resize(pg_num);
+
+  acting->resize(pg_num);
+  acting_primary->resize(pg_num);
+  for (unsigned ps = 0; ps < pg_num; ++ps) {
+    pg_t pg(ps, poolid);
+    vector<int> up;
+    int up_primary;
+    _remove_nonexistent_osds(*pool, raw[ps]);
+    _raw_to_up_osds(*pool, raw[ps], &up, &up_primary);
+    _apply_primary_affinity(pps[ps], *pool, &up, &up_primary);
+    _get_temp_osds(*pool, pg, &(*acting)[ps], &(*acting_primary)[ps]);
+    if ((*acting)[ps].empty()) {
+      (*acting)[ps].swap(up);
+      if ((*acting_primary)[ps] == -1)
+	(*acting_primary)[ps] = up_primary;
+    }
+  }
+}
+
 int OSDMap::calc_pg_rank(int osd, const vector<int>& acting, int nrep)
 {
   if (!nrep)
@@ -2083,6 +2155,8 @@ void OSDMap::decode_classic(bufferlist::iterator& p)
 
 void OSDMap::decode(bufferlist::iterator& bl)
 {
+  pg_mapping_cache.reset();
+
   /**
    * Older encodings of the OSDMap had a single struct_v which
    * covered the whole encoding, and was prior to our modern
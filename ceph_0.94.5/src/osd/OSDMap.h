@@ -285,6 +285,27 @@ private:
   mutable bool crc_defined;
   mutable uint32_t crc;
 
+  /**
+   * up/acting sets already computed for this epoch
+   *
+   * Only set up (by enable_pg_mapping_cache()) on maps that won't change
+   * any more; the OSD looks up the same pgs in the same epoch several
+   * times (advance_pg, project_pg_history, past intervals, pg creation).
+   * Tied to the epoch it was enabled for, and dropped by anything that
+   * loads a different map into this object.
+   */
+  struct pg_mapping_t {
+    vector<int> up, acting;
+    int up_primary, acting_primary;
+  };
+  struct PGMappingCache {
+    Mutex lock;
+    epoch_t epoch;
+    ceph::unordered_map<pg_t, pg_mapping_t> mappings;
+    PGMappingCache(epoch_t e) : lock("OSDMap::PGMappingCache::lock"), epoch(e) {}
+  };
+  ceph::shared_ptr<PGMappingCache> pg_mapping_cache;
+
   void _calc_up_osd_features();
 
  public:
@@ -333,6 +354,13 @@ public:
 
     // NOTE: we do not copy crush.  note that apply_incremental will
     // allocate a new CrushWrapper, though.
+
+    pg_mapping_cache.reset();
+  }
+
+  /// remember up/acting lookups; the map must not be modified afterwards
+  void enable_pg_mapping_cache() {
+    pg_mapping_cache.reset(new PGMappingCache(epoch));
   }
 
   // map info
@@ -715,6 +743,16 @@ public:
     int up_primary, acting_primary;
     pg_to_up_acting_osds(pg, &up, &up_primary, &acting, &acting_primary);
   }
+  /**
+   * map every pg of a pool to its acting set
+   *
+   * Same as calling pg_to_acting_osds() for ps 0..pg_num-1, but runs
+   * CRUSH for the whole pool as one batch.  Use this when you need the
+   * entire pool (remap checks, osdmaptool --test-map-pgs).
+   * Both pointers must be non-NULL.
+   */
+  void pool_to_acting_osds(int64_t poolid, vector<vector<int> > *acting,
+			   vector<int> *acting_primary) const;
   bool pg_is_ec(pg_t pg) const {
     map<int64_t, pg_pool_t>::const_iterator i = pools.find(pg.pool());
     assert(i != pools.end());
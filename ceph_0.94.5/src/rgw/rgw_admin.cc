@@ -32,6 +32,7 @@ using namespace std;
 #include "rgw_usage.h"
 #include "rgw_replica_log.h"
 #include "rgw_orphan.h"
+#include "rgw_gc.h"
 
 #define dout_subsys ceph_subsys_rgw
 
@@ -94,6 +95,8 @@ void _usage()
   cerr << "  gc list                    dump expired garbage collection objects (specify\n";
   cerr << "                             --include-all to list all entries, including unexpired)\n";
   cerr << "  gc process                 manually process garbage\n";
+  cerr << "  gc status                  show number of pending and expired gc entries\n";
+  cerr << "                             per gc shard\n";
   cerr << "  metadata get               get metadata info\n";
   cerr << "  metadata put               put metadata info\n";
   cerr << "  metadata rm                remove metadata info\n";
@@ -235,6 +238,7 @@ enum {
   OPT_QUOTA_DISABLE,
   OPT_GC_LIST,
   OPT_GC_PROCESS,
+  OPT_GC_STATUS,
   OPT_ORPHANS_FIND,
   OPT_ORPHANS_FINISH,
   OPT_REGION_GET,
@@ -447,6 +451,8 @@ static int get_cmd(const char *cmd, const char *prev_cmd, bool *need_more)
       return OPT_GC_LIST;
     if (strcmp(cmd, "process") == 0)
       return OPT_GC_PROCESS;
+    if (strcmp(cmd, "status") == 0)
+      return OPT_GC_STATUS;
   } else if (strcmp(prev_cmd, "orphans") == 0) {
     if (strcmp(cmd, "find") == 0)
       return OPT_ORPHANS_FIND;
@@ -2589,6 +2595,34 @@ next:
     }
   }
 
+  if (opt_cmd == OPT_GC_STATUS) {
+    uint64_t total_entries = 0;
+    uint64_t total_expired = 0;
+    formatter->open_object_section("gc_status");
+    formatter->open_array_section("shards");
+    int max_objs = store->get_gc_max_objs();
+    for (int i = 0; i < max_objs; i++) {
+      RGWGCShardStatus status;
+      int ret = store->get_gc_shard_status(i, &status);
+      if (ret < 0) {
+	cerr << "ERROR: failed to read gc shard " << i << ": " << cpp_strerror(-ret) << std::endl;
+	return 1;
+      }
+      formatter->open_object_section("shard");
+      formatter->dump_int("index", i);
+      formatter->dump_unsigned("entries", status.num_entries);
+      formatter->dump_unsigned("expired", status.num_expired);
+      formatter->close_section();
+      total_entries += status.num_entries;
+      total_expired += status.num_expired;
+    }
+    formatter->close_section(); // shards
+    formatter->dump_unsigned("total_entries", total_entries);
+    formatter->dump_unsigned("total_expired", total_expired);
+    formatter->close_section();
+    formatter->flush(cout);
+  }
+
   if (opt_cmd == OPT_ORPHANS_FIND) {
     RGWOrphanSearch search(store, max_concurrent_ios, orphan_stale_secs);
 
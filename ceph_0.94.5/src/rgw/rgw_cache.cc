@@ -2,6 +2,7 @@
 // vim: ts=8 sw=2 smarttab
 
 #include "rgw_cache.h"
+#include "include/ceph_hash.h"
 
 #include <errno.h>
 
@@ -9,16 +10,77 @@
 
 using namespace std;
 
+ObjectCache::~ObjectCache()
+{
+  for (vector<ObjectCacheShard *>::iterator iter = shards.begin(); iter != shards.end(); ++iter) {
+    delete *iter;
+  }
+}
+
+void ObjectCache::set_ctx(CephContext *_cct)
+{
+  cct = _cct;
+
+  unsigned num_shards = MAX(1, cct->_conf->rgw_cache_shards);
+  max_entries = MAX(1, cct->_conf->rgw_cache_lru_size / num_shards);
+  max_bytes = cct->_conf->rgw_cache_max_bytes / num_shards;
+
+  const string& policy = cct->_conf->rgw_cache_eviction_policy;
+  if (policy == "clock") {
+    use_clock = true;
+  } else {
+    if (policy != "lru") {
+      lderr(cct) << "unknown rgw_cache_eviction_policy " << policy << ", using lru" << dendl;
+    }
+    use_clock = false;
+  }
+
+  assert(shards.empty());
+  for (unsigned i = 0; i < num_shards; i++) {
+    ObjectCacheShard *shard = new ObjectCacheShard;
+    shard->lru_window = max_entries / 2;
+    shards.push_back(shard);
+  }
+  ldout(cct, 10) << "cache: " << num_shards << " shards, " << max_entries << " entries/"
+                 << max_bytes << " bytes per shard, policy=" << (use_clock ? "clock" : "lru") << dendl;
+}
+
+unsigned ObjectCache::get_shard_index(const string& name)
+{
+  return ceph_str_hash_linux(name.c_str(), name.size()) % shards.size();
+}
+
+ObjectCacheShard *ObjectCache::get_shard(const string& name)
+{
+  return shards[get_shard_index(name)];
+}
+
+uint64_t ObjectCache::calc_entry_size(const string& name, const ObjectCacheEntry& entry)
+{
+  /* the name is stored twice, in the map key and in the lru */
+  uint64_t size = sizeof(ObjectCacheEntry) + name.size() * 2 + entry.info.data.length();
+  for (map<string, bufferlist>::const_iterator iter = entry.info.xattrs.begin();
+       iter != entry.info.xattrs.end(); ++iter) {
+    size += iter->first.size() + iter->second.length();
+  }
+  return size;
+}
+
 int ObjectCache::get(string& name, ObjectCacheInfo& info, uint32_t mask, rgw_cache_entry_info *cache_info)
 {
-  RWLock::RLocker l(lock);
+  if (shards.empty()) {
+    return -ENOENT;
+  }
+
+  ObjectCacheShard *shard = get_shard(name);
+  RWLock::RLocker l(shard->lock);
 
   if (!enabled) {
     return -ENOENT;
   }
 
-  map<string, ObjectCacheEntry>::iterator iter = cache_map.find(name);
-  if (iter == cache_map.end()) {
+  map<string, ObjectCacheEntry>::iterator iter = shard->cache_map.find(name);
+  if (iter == shard->cache_map.end()) {
     ldout(cct, 10) << "cache get: name=" << name << " : miss" << dendl;
     if(perfcounter) perfcounter->inc(l_rgw_cache_miss);
     return -ENOENT;
@@ -26,14 +88,18 @@ int ObjectCache::get(string& name, ObjectCacheInfo& info, uint32_t mask, rgw_cac
 
   ObjectCacheEntry *entry = &iter->second;
 
-  if (lru_counter - entry->lru_promotion_ts > lru_window) {
-    ldout(cct, 20) << "cache get: touching lru, lru_counter=" << lru_counter << " promotion_ts=" << entry->lru_promotion_ts << dendl;
-    lock.unlock();
-    lock.get_write(); /* promote lock to writer */
+  if (use_clock) {
+    /* CLOCK only needs the reference bit set, no lock promotion */
+    if (!entry->referenced.read())
+      entry->referenced.set(1);
+  } else if (shard->lru_counter - entry->lru_promotion_ts > shard->lru_window) {
+    ldout(cct, 20) << "cache get: touching lru, lru_counter=" << shard->lru_counter << " promotion_ts=" << entry->lru_promotion_ts << dendl;
+    shard->lock.unlock();
+    shard->lock.get_write(); /* promote lock to writer */
 
     /* need to redo this because entry might have dropped off the cache */
-    iter = cache_map.find(name);
-    if (iter == cache_map.end()) {
+    iter = shard->cache_map.find(name);
+    if (iter == shard->cache_map.end()) {
       ldout(cct, 10) << "lost race! cache get: name=" << name << " : miss" << dendl;
       if(perfcounter) perfcounter->inc(l_rgw_cache_miss);
       return -ENOENT;
@@ -41,8 +107,8 @@ int ObjectCache::get(string& name, ObjectCacheInfo& info, uint32_t mask, rgw_cac
 
     entry = &iter->second;
     /* check again, we might have lost a race here */
-    if (lru_counter - entry->lru_promotion_ts > lru_window) {
-      touch_lru(name, *entry, iter->second.lru_iter);
+    if (shard->lru_counter - entry->lru_promotion_ts > shard->lru_window) {
+      touch_lru(shard, name, *entry, iter->second.lru_iter);
     }
   }
 
@@ -66,32 +132,49 @@ int ObjectCache::get(string& name, ObjectCacheInfo& info, uint32_t mask, rgw_cac
 
 bool ObjectCache::chain_cache_entry(list<rgw_cache_entry_info *>& cache_info_entries, RGWChainedCache::Entry *chained_entry)
 {
-  RWLock::WLocker l(lock);
-
-  if (!enabled) {
+  if (shards.empty()) {
     return false;
   }
 
   list<rgw_cache_entry_info *>::iterator citer;
 
+  /*
+   * the entries may live in different shards; take the write lock of
+   * every shard involved, in index order so that we can't deadlock
+   * against another chainer
+   */
+  set<unsigned> shard_ids;
+  for (citer = cache_info_entries.begin(); citer != cache_info_entries.end(); ++citer) {
+    shard_ids.insert(get_shard_index((*citer)->cache_locator));
+  }
+  for (set<unsigned>::iterator siter = shard_ids.begin(); siter != shard_ids.end(); ++siter) {
+    shards[*siter]->lock.get_write();
+  }
+
+  bool ret = false;
   list<ObjectCacheEntry *> cache_entry_list;
 
+  if (!enabled) {
+    goto out;
+  }
+
   /* first verify that all entries are still valid */
   for (citer = cache_info_entries.begin(); citer != cache_info_entries.end(); ++citer) {
     rgw_cache_entry_info *cache_info = *citer;
 
     ldout(cct, 10) << "chain_cache_entry: cache_locator=" << cache_info->cache_locator << dendl;
-    map<string, ObjectCacheEntry>::iterator iter = cache_map.find(cache_info->cache_locator);
-    if (iter == cache_map.end()) {
+    ObjectCacheShard *shard = get_shard(cache_info->cache_locator);
+    map<string, ObjectCacheEntry>::iterator iter = shard->cache_map.find(cache_info->cache_locator);
+    if (iter == shard->cache_map.end()) {
       ldout(cct, 20) << "chain_cache_entry: couldn't find cachce locator" << dendl;
-      return false;
+      goto out;
     }
 
     ObjectCacheEntry *entry = &iter->second;
 
     if (entry->gen != cache_info->gen) {
       ldout(cct, 20) << "chain_cache_entry: entry.gen (" << entry->gen << ") != cache_info.gen (" << cache_info->gen << ")" << dendl;
-      return false;
+      goto out;
     }
 
     cache_entry_list.push_back(entry);
@@ -100,32 +183,39 @@ bool ObjectCache::chain_cache_entry(list<rgw_cache_entry_info *>& cache_info_ent
 
   chained_entry->cache->chain_cb(chained_entry->key, chained_entry->data);
 
-  list<ObjectCacheEntry *>::iterator liter;
-
-  for (liter = cache_entry_list.begin(); liter != cache_entry_list.end(); ++liter) {
+  for (list<ObjectCacheEntry *>::iterator liter = cache_entry_list.begin(); liter != cache_entry_list.end(); ++liter) {
     ObjectCacheEntry *entry = *liter;
 
     entry->chained_entries.push_back(make_pair<RGWChainedCache *, string>(chained_entry->cache, chained_entry->key));
   }
+  ret = true;
 
-  return true;
+out:
+  for (set<unsigned>::reverse_iterator siter = shard_ids.rbegin(); siter != shard_ids.rend(); ++siter) {
+    shards[*siter]->lock.unlock();
+  }
+  return ret;
 }
 
 void ObjectCache::put(string& name, ObjectCacheInfo& info, rgw_cache_entry_info *cache_info)
 {
-  RWLock::WLocker l(lock);
+  if (shards.empty()) {
+    return;
+  }
+
+  ObjectCacheShard *shard = get_shard(name);
+  RWLock::WLocker l(shard->lock);
 
   if (!enabled) {
     return;
   }
 
   ldout(cct, 10) << "cache put: name=" << name << dendl;
-  map<string, ObjectCacheEntry>::iterator iter = cache_map.find(name);
-  if (iter == cache_map.end()) {
+  map<string, ObjectCacheEntry>::iterator iter = shard->cache_map.find(name);
+  if (iter == shard->cache_map.end()) {
     ObjectCacheEntry entry;
-    entry.lru_iter = lru.end();
-    cache_map.insert(pair<string, ObjectCacheEntry>(name, entry));
-    iter = cache_map.find(name);
+    entry.lru_iter = shard->lru.end();
+    iter = shard->cache_map.insert(pair<string, ObjectCacheEntry>(name, entry)).first;
   }
   ObjectCacheEntry& entry = iter->second;
   ObjectCacheInfo& target = entry.info;
@@ -139,64 +229,74 @@ void ObjectCache::put(string& name, ObjectCacheInfo& info, rgw_cache_entry_info
   entry.chained_entries.clear();
   entry.gen++;
 
-  touch_lru(name, entry, entry.lru_iter);
-
   target.status = info.status;
 
   if (info.status < 0) {
     target.flags = 0;
     target.xattrs.clear();
     target.data.clear();
-    return;
-  }
-
-  if (cache_info) {
-    cache_info->cache_locator = name;
-    cache_info->gen = entry.gen;
-  }
+  } else {
+    if (cache_info) {
+      cache_info->cache_locator = name;
+      cache_info->gen = entry.gen;
+    }
 
-  target.flags |= info.flags;
+    target.flags |= info.flags;
+
+    if (info.flags & CACHE_FLAG_META)
+      target.meta = info.meta;
+    else if (!(info.flags & CACHE_FLAG_MODIFY_XATTRS))
+      target.flags &= ~CACHE_FLAG_META; // non-meta change should reset meta
+
+    if (info.flags & CACHE_FLAG_XATTRS) {
+      target.xattrs = info.xattrs;
+      map<string, bufferlist>::iterator iter;
+      for (iter = target.xattrs.begin(); iter != target.xattrs.end(); ++iter) {
+        ldout(cct, 10) << "updating xattr: name=" << iter->first << " bl.length()=" << iter->second.length() << dendl;
+      }
+    } else if (info.flags & CACHE_FLAG_MODIFY_XATTRS) {
+      map<string, bufferlist>::iterator iter;
+      for (iter = info.rm_xattrs.begin(); iter != info.rm_xattrs.end(); ++iter) {
+        ldout(cct, 10) << "removing xattr: name=" << iter->first << dendl;
+        target.xattrs.erase(iter->first);
+      }
+      for (iter = info.xattrs.begin(); iter != info.xattrs.end(); ++iter) {
+        ldout(cct, 10) << "appending xattr: name=" << iter->first << " bl.length()=" << iter->second.length() << dendl;
+        target.xattrs[iter->first] = iter->second;
+      }
+    }
 
-  if (info.flags & CACHE_FLAG_META)
-    target.meta = info.meta;
-  else if (!(info.flags & CACHE_FLAG_MODIFY_XATTRS))
-    target.flags &= ~CACHE_FLAG_META; // non-meta change should reset meta
+    if (info.flags & CACHE_FLAG_DATA)
+      target.data = info.data;
 
-  if (info.flags & CACHE_FLAG_XATTRS) {
-    target.xattrs = info.xattrs;
-    map<string, bufferlist>::iterator iter;
-    for (iter = target.xattrs.begin(); iter != target.xattrs.end(); ++iter) {
-      ldout(cct, 10) << "updating xattr: name=" << iter->first << " bl.length()=" << iter->second.length() << dendl;
-    }
-  } else if (info.flags & CACHE_FLAG_MODIFY_XATTRS) {
-    map<string, bufferlist>::iterator iter;
-    for (iter = info.rm_xattrs.begin(); iter != info.rm_xattrs.end(); ++iter) {
-      ldout(cct, 10) << "removing xattr: name=" << iter->first << dendl;
-      target.xattrs.erase(iter->first);
-    }
-    for (iter = info.xattrs.begin(); iter != info.xattrs.end(); ++iter) {
-      ldout(cct, 10) << "appending xattr: name=" << iter->first << " bl.length()=" << iter->second.length() << dendl;
-      target.xattrs[iter->first] = iter->second;
-    }
+    if (info.flags & CACHE_FLAG_OBJV)
+      target.version = info.version;
   }
 
-  if (info.flags & CACHE_FLAG_DATA)
-    target.data = info.data;
+  /* account the entry with its new contents before trimming around it */
+  uint64_t new_size = calc_entry_size(name, entry);
+  shard->size -= entry.size;
+  shard->size += new_size;
+  entry.size = new_size;
 
-  if (info.flags & CACHE_FLAG_OBJV)
-    target.version = info.version;
+  touch_lru(shard, name, entry, entry.lru_iter);
 }
 
 void ObjectCache::remove(string& name)
 {
-  RWLock::WLocker l(lock);
+  if (shards.empty()) {
+    return;
+  }
+
+  ObjectCacheShard *shard = get_shard(name);
+  RWLock::WLocker l(shard->lock);
 
   if (!enabled) {
     return;
   }
 
-  map<string, ObjectCacheEntry>::iterator iter = cache_map.find(name);
-  if (iter == cache_map.end())
+  map<string, ObjectCacheEntry>::iterator iter = shard->cache_map.find(name);
+  if (iter == shard->cache_map.end())
     return;
 
   ldout(cct, 10) << "removing " << name << " from cache" << dendl;
@@ -208,90 +308,170 @@ void ObjectCache::remove(string& name)
     chained_cache->invalidate(iiter->second);
   }
 
-  remove_lru(name, iter->second.lru_iter);
-  cache_map.erase(iter);
+  remove_lru(shard, name, iter->second.lru_iter);
+  shard->size -= entry.size;
+  shard->cache_map.erase(iter);
 }
 
-void ObjectCache::touch_lru(string& name, ObjectCacheEntry& entry, std::list<string>::iterator& lru_iter)
+void ObjectCache::evict_entry(ObjectCacheShard *shard, map<string, ObjectCacheEntry>::iterator& iter)
 {
-  while (lru_size > (size_t)cct->_conf->rgw_cache_lru_size) {
-    list<string>::iterator iter = lru.begin();
-    if ((*iter).compare(name) == 0) {
+  ObjectCacheEntry& entry = iter->second;
+  for (list<pair<RGWChainedCache *, string> >::iterator iiter = entry.chained_entries.begin();
+       iiter != entry.chained_entries.end(); ++iiter) {
+    iiter->first->invalidate(iiter->second);
+  }
+  shard->size -= entry.size;
+  shard->cache_map.erase(iter);
+  if (perfcounter) perfcounter->inc(l_rgw_cache_evict);
+}
+
+void ObjectCache::trim_lru(ObjectCacheShard *shard, const string& keep)
+{
+  while (over_limit(shard) && !shard->lru.empty()) {
+    list<string>::iterator iter = shard->lru.begin();
+    if ((*iter).compare(keep) == 0) {
       /*
        * if the entry we're touching happens to be at the lru end, don't remove it,
        * lru shrinking can wait for next time
        */
       break;
     }
-    map<string, ObjectCacheEntry>::iterator map_iter = cache_map.find(*iter);
+    map<string, ObjectCacheEntry>::iterator map_iter = shard->cache_map.find(*iter);
     ldout(cct, 10) << "removing entry: name=" << *iter << " from cache LRU" << dendl;
-    if (map_iter != cache_map.end())
-      cache_map.erase(map_iter);
-    lru.pop_front();
-    lru_size--;
+    if (map_iter != shard->cache_map.end())
+      evict_entry(shard, map_iter);
+    shard->lru.pop_front();
+    shard->lru_size--;
   }
+}
 
-  if (lru_iter == lru.end()) {
-    lru.push_back(name);
-    lru_size++;
+void ObjectCache::trim_clock(ObjectCacheShard *shard, const string& keep)
+{
+  /*
+   * the lru list is used as the clock ring, the hand is at its front.
+   * referenced entries get a second chance and are rotated to the back;
+   * every entry can be passed over at most once, so bound the sweep.
+   */
+  unsigned long budget = shard->lru_size * 2;
+  while (over_limit(shard) && !shard->lru.empty() && budget-- > 0) {
+    list<string>::iterator iter = shard->lru.begin();
+    map<string, ObjectCacheEntry>::iterator map_iter = shard->cache_map.find(*iter);
+    if (map_iter == shard->cache_map.end()) {
+      shard->lru.pop_front();
+      shard->lru_size--;
+      continue;
+    }
+    ObjectCacheEntry& entry = map_iter->second;
+    if ((*iter).compare(keep) == 0 || entry.referenced.read()) {
+      entry.referenced.set(0);
+      shard->lru.splice(shard->lru.end(), shard->lru, iter);
+      continue;
+    }
+    ldout(cct, 10) << "removing entry: name=" << *iter << " from cache CLOCK" << dendl;
+    evict_entry(shard, map_iter);
+    shard->lru.pop_front();
+    shard->lru_size--;
+  }
+}
+
+void ObjectCache::touch_lru(ObjectCacheShard *shard, string& name, ObjectCacheEntry& entry, std::list<string>::iterator& lru_iter)
+{
+  if (use_clock) {
+    if (lru_iter == shard->lru.end()) {
+      shard->lru.push_back(name);
+      shard->lru_size++;
+      lru_iter--;
+      ldout(cct, 10) << "adding " << name << " to cache CLOCK" << dendl;
+    } else {
+      entry.referenced.set(1);
+    }
+    trim_clock(shard, name);
+    return;
+  }
+
+  trim_lru(shard, name);
+
+  if (lru_iter == shard->lru.end()) {
+    shard->lru.push_back(name);
+    shard->lru_size++;
     lru_iter--;
     ldout(cct, 10) << "adding " << name << " to cache LRU end" << dendl;
   } else {
     ldout(cct, 10) << "moving " << name << " to cache LRU end" << dendl;
-    lru.erase(lru_iter);
-    lru.push_back(name);
-    lru_iter = lru.end();
+    shard->lru.splice(shard->lru.end(), shard->lru, lru_iter);
+    lru_iter = shard->lru.end();
     --lru_iter;
   }
 
-  lru_counter++;
-  entry.lru_promotion_ts = lru_counter;
+  shard->lru_counter++;
+  entry.lru_promotion_ts = shard->lru_counter;
 }
 
-void ObjectCache::remove_lru(string& name, std::list<string>::iterator& lru_iter)
+void ObjectCache::remove_lru(ObjectCacheShard *shard, string& name, std::list<string>::iterator& lru_iter)
 {
-  if (lru_iter == lru.end())
+  if (lru_iter == shard->lru.end())
     return;
 
-  lru.erase(lru_iter);
-  lru_size--;
-  lru_iter = lru.end();
+  shard->lru.erase(lru_iter);
+  shard->lru_size--;
+  lru_iter = shard->lru.end();
+}
+
+void ObjectCache::lock_all()
+{
+  for (vector<ObjectCacheShard *>::iterator iter = shards.begin(); iter != shards.end(); ++iter) {
+    (*iter)->lock.get_write();
+  }
+}
+
+void ObjectCache::unlock_all()
+{
+  for (vector<ObjectCacheShard *>::reverse_iterator iter = shards.rbegin(); iter != shards.rend(); ++iter) {
+    (*iter)->lock.unlock();
+  }
 }
 
 void ObjectCache::set_enabled(bool status)
 {
-  RWLock::WLocker l(lock);
+  lock_all();
 
   enabled = status;
 
   if (!enabled) {
     do_invalidate_all();
   }
+
+  unlock_all();
 }
 
 void ObjectCache::invalidate_all()
 {
-  RWLock::WLocker l(lock);
+  lock_all();
 
   do_invalidate_all();
+
+  unlock_all();
 }
 
 void ObjectCache::do_invalidate_all()
 {
-  cache_map.clear();
-  lru.clear();
-
-  lru_size = 0;
-  lru_counter = 0;
-  lru_window = 0;
+  for (vector<ObjectCacheShard *>::iterator iter = shards.begin(); iter != shards.end(); ++iter) {
+    ObjectCacheShard *shard = *iter;
+    shard->cache_map.clear();
+    shard->lru.clear();
+
+    shard->lru_size = 0;
+    shard->lru_counter = 0;
+    shard->size = 0;
+  }
 
+  Mutex::Locker l(chained_lock);
   for (list<RGWChainedCache *>::iterator iter = chained_cache.begin(); iter != chained_cache.end(); ++iter) {
     (*iter)->invalidate_all();
   }
 }
 
 void ObjectCache::chain_cache(RGWChainedCache *cache) {
-  RWLock::WLocker l(lock);
+  Mutex::Locker l(chained_lock);
   chained_cache.push_back(cache);
 }
-
@@ -11,6 +11,8 @@
 #include "include/utime.h"
 #include "include/assert.h"
 #include "common/RWLock.h"
+#include "common/Mutex.h"
+#include "include/atomic.h"
 
 enum {
   UPDATE_OBJ,
@@ -132,37 +134,74 @@ struct ObjectCacheEntry {
   std::list<string>::iterator lru_iter;
   uint64_t lru_promotion_ts;
   uint64_t gen;
+  uint64_t size;  /* bytes accounted against the shard */
+  atomic_t referenced; /* CLOCK reference bit, set on hit without the write lock */
   std::list<pair<RGWChainedCache *, string> > chained_entries;
 
-  ObjectCacheEntry() : lru_promotion_ts(0), gen(0) {}
+  ObjectCacheEntry() : lru_promotion_ts(0), gen(0), size(0) {}
+  ObjectCacheEntry(const ObjectCacheEntry& o)
+    : info(o.info), lru_iter(o.lru_iter), lru_promotion_ts(o.lru_promotion_ts),
+      gen(o.gen), size(o.size), referenced(o.referenced.read()),
+      chained_entries(o.chained_entries) {}
+private:
+  ObjectCacheEntry& operator=(const ObjectCacheEntry& o);
 };
 
-class ObjectCache {
+/*
+ * One lock stripe of the ObjectCache.  Each shard owns its own map, LRU
+ * (or CLOCK ring) and size accounting, so lookups for names that hash to
+ * different shards never contend.
+ */
+struct ObjectCacheShard {
   std::map<string, ObjectCacheEntry> cache_map;
   std::list<string> lru;
   unsigned long lru_size;
   unsigned long lru_counter;
   unsigned long lru_window;
+  uint64_t size;
   RWLock lock;
+
+  ObjectCacheShard() : lru_size(0), lru_counter(0), lru_window(0), size(0),
+                       lock("ObjectCacheShard::lock") {}
+};
+
+class ObjectCache {
+  vector<ObjectCacheShard *> shards;
+  unsigned long max_entries;   /* per shard */
+  uint64_t max_bytes;          /* per shard, 0 for unlimited */
+  bool use_clock;
   CephContext *cct;
 
+  Mutex chained_lock;
   list<RGWChainedCache *> chained_cache;
 
   bool enabled;
 
-  void touch_lru(string& name, ObjectCacheEntry& entry, std::list<string>::iterator& lru_iter);
-  void remove_lru(string& name, std::list<string>::iterator& lru_iter);
+  ObjectCacheShard *get_shard(const string& name);
+  unsigned get_shard_index(const string& name);
+
+  void touch_lru(ObjectCacheShard *shard, string& name, ObjectCacheEntry& entry, std::list<string>::iterator& lru_iter);
+  void remove_lru(ObjectCacheShard *shard, string& name, std::list<string>::iterator& lru_iter);
+  void trim_lru(ObjectCacheShard *shard, const string& keep);
+  void trim_clock(ObjectCacheShard *shard, const string& keep);
+  void evict_entry(ObjectCacheShard *shard, map<string, ObjectCacheEntry>::iterator& iter);
+  bool over_limit(ObjectCacheShard *shard) {
+    return shard->lru_size > max_entries ||
+      (max_bytes && shard->size > max_bytes);
+  }
+  static uint64_t calc_entry_size(const string& name, const ObjectCacheEntry& entry);
 
+  void lock_all();
+  void unlock_all();
   void do_invalidate_all();
 public:
-  ObjectCache() : lru_size(0), lru_counter(0), lru_window(0), lock("ObjectCache"), cct(NULL), enabled(false) { }
+  ObjectCache() : max_entries(0), max_bytes(0), use_clock(false), cct(NULL),
+                  chained_lock("ObjectCache::chained_lock"), enabled(false) { }
+  ~ObjectCache();
   int get(std::string& name, ObjectCacheInfo& bl, uint32_t mask, rgw_cache_entry_info *cache_info);
   void put(std::string& name, ObjectCacheInfo& bl, rgw_cache_entry_info *cache_info);
   void remove(std::string& name);
-  void set_ctx(CephContext *_cct) {
-    cct = _cct;
-    lru_window = cct->_conf->rgw_cache_lru_size / 2;
-  }
+  void set_ctx(CephContext *_cct);
   bool chain_cache_entry(list<rgw_cache_entry_info *>& cache_info_entries, RGWChainedCache::Entry *chained_entry);
 
   void set_enabled(bool status);
@@ -47,10 +47,15 @@ int rgw_perf_start(CephContext *cct)
 
   plb.add_u64_counter(l_rgw_cache_hit, "cache_hit");
   plb.add_u64_counter(l_rgw_cache_miss, "cache_miss");
+  plb.add_u64_counter(l_rgw_cache_evict, "cache_evict");
 
   plb.add_u64_counter(l_rgw_keystone_token_cache_hit, "keystone_token_cache_hit");
   plb.add_u64_counter(l_rgw_keystone_token_cache_miss, "keystone_token_cache_miss");
 
+  plb.add_u64_counter(l_rgw_gc_removed_obj, "gc_removed_obj");
+  plb.add_u64_counter(l_rgw_gc_remove_failed, "gc_remove_failed");
+  plb.add_u64_counter(l_rgw_gc_removed_tags, "gc_removed_tags");
+
   perfcounter = plb.create_perf_counters();
   cct->get_perfcounters_collection()->add(perfcounter);
   return 0;
@@ -180,10 +180,15 @@ enum {
 
   l_rgw_cache_hit,
   l_rgw_cache_miss,
+  l_rgw_cache_evict,
 
   l_rgw_keystone_token_cache_hit,
   l_rgw_keystone_token_cache_miss,
 
+  l_rgw_gc_removed_obj,
+  l_rgw_gc_remove_failed,
+  l_rgw_gc_removed_tags,
+
   l_rgw_last,
 };
 
@@ -9,6 +9,7 @@
 #include "auth/Crypto.h"
 
 #include <list>
+#include <deque>
 
 #define dout_subsys ceph_subsys_rgw
 
@@ -84,11 +85,14 @@ int RGWGC::defer_chain(const string& tag, bool sync)
   return store->gc_aio_operate(obj_names[i], &op);
 }
 
-int RGWGC::remove(int index, const std::list<string>& tags)
+int RGWGC::remove(int index, const std::list<string>& tags, bool sync)
 {
   ObjectWriteOperation op;
   cls_rgw_gc_remove(op, tags);
-  return store->gc_operate(obj_names[index], &op);
+  if (sync)
+    return store->gc_operate(obj_names[index], &op);
+
+  return store->gc_aio_operate(obj_names[index], &op);
 }
 
 int RGWGC::list(int *index, string& marker, uint32_t max, bool expired_only, std::list<cls_rgw_gc_obj_info>& result, bool *truncated)
@@ -128,38 +132,147 @@ int RGWGC::list(int *index, string& marker, uint32_t max, bool expired_only, std
   return 0;
 }
 
-int RGWGC::process(int index, int max_secs)
+void RGWGCIOManager::throttle_foreground()
 {
-  rados::cls::lock::Lock l(gc_index_lock_name);
-  utime_t end = ceph_clock_now(g_ceph_context);
-  std::list<string> remove_tags;
+  int max_active = cct->_conf->rgw_gc_throttle_active_requests;
+  if (max_active <= 0 || !perfcounter)
+    return;
 
-  /* max_secs should be greater than zero. We don't want a zero max_secs
-   * to be translated as no timeout, since we'd then need to break the
-   * lock and that would require a manual intervention. In this case
-   * we can just wait it out. */
-  if (max_secs <= 0)
-    return -EAGAIN;
+  /* back off while the gateway is busy serving clients */
+  while ((int)perfcounter->get(l_rgw_qactive) > max_active && !gc->going_down()) {
+    usleep(100 * 1000);
+  }
+}
 
-  end += max_secs;
-  utime_t time(max_secs, 0);
-  l.set_duration(time);
+void RGWGCIOManager::start_tag(const string& tag)
+{
+  tags[tag] = TagState();
+}
 
-  int ret = l.lock_exclusive(&store->gc_pool_ctx, obj_names[index]);
-  if (ret == -EBUSY) { /* already locked by another gc processor */
-    dout(0) << "RGWGC::process() failed to acquire lock on " << obj_names[index] << dendl;
-    return 0;
+void RGWGCIOManager::fail_tag(const string& tag)
+{
+  tags[tag].failed = true;
+}
+
+int RGWGCIOManager::schedule_io(IoCtx *ioctx, const string& oid, ObjectWriteOperation *op, int index, const string& tag)
+{
+  while (ios.size() >= max_aio) {
+    handle_next_completion();
   }
-  if (ret < 0)
+
+  throttle_foreground();
+
+  IO io;
+  io.c = librados::Rados::aio_create_completion(NULL, NULL, NULL);
+  io.index = index;
+  io.tag = tag;
+  io.oid = oid;
+  int ret = ioctx->aio_operate(oid, io.c, op);
+  if (ret < 0) {
+    io.c->release();
     return ret;
+  }
+  ios.push_back(io);
+  tags[tag].pending++;
+  return 0;
+}
+
+void RGWGCIOManager::end_tag(int index, const string& tag)
+{
+  TagState& state = tags[tag];
+  state.scheduled = true;
+  if (state.pending == 0)
+    finish_tag(index, tag);
+}
+
+void RGWGCIOManager::handle_next_completion()
+{
+  assert(!ios.empty());
+  IO& io = ios.front();
+  io.c->wait_for_complete();
+  int ret = io.c->get_return_value();
+  io.c->release();
+
+  if (ret == -ENOENT)
+    ret = 0;
+
+  TagState& state = tags[io.tag];
+  if (ret < 0) {
+    dout(0) << "failed to remove " << io.oid << " tag=" << io.tag << " ret=" << ret << dendl;
+    state.failed = true;
+    if (perfcounter) perfcounter->inc(l_rgw_gc_remove_failed);
+  } else {
+    if (perfcounter) perfcounter->inc(l_rgw_gc_removed_obj);
+  }
+
+  int index = io.index;
+  string tag = io.tag;
+  ios.pop_front();
+
+  if (--state.pending == 0 && state.scheduled)
+    finish_tag(index, tag);
+}
+
+void RGWGCIOManager::finish_tag(int index, const string& tag)
+{
+  map<string, TagState>::iterator iter = tags.find(tag);
+  assert(iter != tags.end());
+  bool failed = iter->second.failed;
+  tags.erase(iter);
+
+  if (failed)
+    return;
+
+  remove_tags[index].push_back(tag);
+  flush_remove_tags(index, cct->_conf->rgw_gc_max_trim_chunk);
+}
+
+void RGWGCIOManager::flush_remove_tags(int index, size_t min_size)
+{
+  std::list<string>& rt = remove_tags[index];
+  if (rt.empty() || rt.size() < min_size)
+    return;
+
+  if (perfcounter) perfcounter->inc(l_rgw_gc_removed_tags, rt.size());
+  int ret = trim_tags(index, rt);
+  if (ret < 0) {
+    dout(0) << "failed to trim " << rt.size() << " tags from gc shard " << index << " ret=" << ret << dendl;
+  }
+  rt.clear();
+}
+
+int RGWGCIOManager::trim_tags(int index, const std::list<string>& tags)
+{
+  return gc->remove(index, tags, false);
+}
+
+void RGWGCIOManager::drain()
+{
+  while (!ios.empty()) {
+    handle_next_completion();
+  }
+  for (map<int, std::list<string> >::iterator iter = remove_tags.begin(); iter != remove_tags.end(); ++iter) {
+    flush_remove_tags(iter->first, 1);
+  }
+  remove_tags.clear();
+  tags.clear();
+}
 
+/*
+ * list the expired entries of a (locked) gc shard and schedule the removal
+ * of their tail objects.  The removals may still be in flight on return.
+ */
+int RGWGC::process(int index, utime_t end, RGWGCIOManager& io_manager)
+{
   string marker;
   bool truncated;
   IoCtx *ctx = new IoCtx;
+  int ret = 0;
   do {
     int max = 100;
     std::list<cls_rgw_gc_obj_info> entries;
-    ret = cls_rgw_gc_list(store->gc_pool_ctx, obj_names[index], marker, max, true, entries, &truncated);
+    string next_marker;
+    ret = cls_rgw_gc_list(store->gc_pool_ctx, obj_names[index], marker, max, true, entries, &truncated, &next_marker);
     if (ret == -ENOENT) {
       ret = 0;
       goto done;
@@ -170,7 +283,6 @@ int RGWGC::process(int index, int max_secs)
     string last_pool;
     std::list<cls_rgw_gc_obj_info>::iterator iter;
     for (iter = entries.begin(); iter != entries.end(); ++iter) {
-      bool remove_tag;
       cls_rgw_gc_obj_info& info = *iter;
       std::list<cls_rgw_obj>::iterator liter;
       cls_rgw_obj_chain& chain = info.chain;
@@ -179,7 +291,7 @@ int RGWGC::process(int index, int max_secs)
       if (now >= end)
         goto done;
 
-      remove_tag = true;
+      io_manager.start_tag(info.tag);
       for (liter = chain.objs.begin(); liter != chain.objs.end(); ++liter) {
         cls_rgw_obj& obj = *liter;
 
@@ -189,6 +301,7 @@ int RGWGC::process(int index, int max_secs)
 	  ret = store->get_rados_handle()->ioctx_create(obj.pool.c_str(), *ctx);
 	  if (ret < 0) {
 	    dout(0) << "ERROR: failed to create ioctx pool=" << obj.pool << dendl;
+            last_pool.clear();
 	    continue;
 	  }
           last_pool = obj.pool;
@@ -202,55 +315,119 @@ int RGWGC::process(int index, int max_secs)
 	dout(0) << "gc::process: removing " << obj.pool << ":" << key_obj.get_object() << dendl;
 	ObjectWriteOperation op;
 	cls_refcount_put(op, info.tag, true);
-        ret = ctx->operate(key_obj.get_object(), &op);
-	if (ret == -ENOENT)
-	  ret = 0;
+        ret = io_manager.schedule_io(ctx, key_obj.get_object(), &op, index, info.tag);
         if (ret < 0) {
-          remove_tag = false;
+          io_manager.fail_tag(info.tag);
           dout(0) << "failed to remove " << obj.pool << ":" << key_obj.get_object() << "@" << obj.loc << dendl;
         }
 
-        if (going_down()) // leave early, even if tag isn't removed, it's ok
+        if (going_down()) { // leave early, even if tag isn't removed, it's ok
+          io_manager.fail_tag(info.tag);
+          io_manager.end_tag(index, info.tag);
           goto done;
-      }
-      if (remove_tag) {
-        remove_tags.push_back(info.tag);
-#define MAX_REMOVE_CHUNK 16
-        if (remove_tags.size() > MAX_REMOVE_CHUNK) {
-          RGWGC::remove(index, remove_tags);
-          remove_tags.clear();
         }
       }
+      io_manager.end_tag(index, info.tag);
     }
-  } while (truncated);
+    marker = next_marker;
+  } while (truncated && !marker.empty());
 
 done:
-  if (!remove_tags.empty())
-    RGWGC::remove(index, remove_tags);
-  l.unlock(&store->gc_pool_ctx, obj_names[index]);
   delete ctx;
-  return 0;
+  return ret;
 }
 
 int RGWGC::process()
 {
   int max_secs = cct->_conf->rgw_gc_processor_max_time;
 
+  /* max_secs should be greater than zero. We don't want a zero max_secs
+   * to be translated as no timeout, since we'd then need to break the
+   * lock and that would require a manual intervention. In this case
+   * we can just wait it out. */
+  if (max_secs <= 0)
+    return -EAGAIN;
+
   unsigned start;
   int ret = get_random_bytes((char *)&start, sizeof(start));
   if (ret < 0)
     return ret;
 
-  for (int i = 0; i < max_objs; i++) {
-    int index = (i + start) % max_objs;
-    ret = process(index, max_secs);
-    if (ret < 0)
+  utime_t end = ceph_clock_now(g_ceph_context);
+  end += max_secs;
+  utime_t time(max_secs, 0);
+
+  int max_shards = MAX(1, cct->_conf->rgw_gc_max_concurrent_shards);
+
+  /*
+   * shards are handled in groups: every shard of a group is locked and its
+   * removals go through the shared io window, then the group is drained
+   * and unlocked before moving on.
+   */
+  for (int i = 0; i < max_objs && !going_down(); ) {
+    RGWGCIOManager io_manager(cct, this);
+    std::list<int> locked;
+
+    for (; i < max_objs && (int)locked.size() < max_shards; i++) {
+      int index = (i + start) % max_objs;
+      rados::cls::lock::Lock l(gc_index_lock_name);
+      l.set_duration(time);
+      ret = l.lock_exclusive(&store->gc_pool_ctx, obj_names[index]);
+      if (ret == -EBUSY) { /* already locked by another gc processor */
+        dout(0) << "RGWGC::process() failed to acquire lock on " << obj_names[index] << dendl;
+        continue;
+      }
+      if (ret < 0)
+        break;
+      locked.push_back(index);
+
+      int r = process(index, end, io_manager);
+      if (r < 0)
+        dout(0) << "RGWGC::process() failed to process shard " << obj_names[index] << " ret=" << r << dendl;
+    }
+
+    io_manager.drain();
+
+    for (std::list<int>::iterator iter = locked.begin(); iter != locked.end(); ++iter) {
+      rados::cls::lock::Lock l(gc_index_lock_name);
+      l.unlock(&store->gc_pool_ctx, obj_names[*iter]);
+    }
+
+    if (ret < 0 && ret != -EBUSY)
       return ret;
+    if (ceph_clock_now(g_ceph_context) >= end)
+      break;
   }
 
   return 0;
 }
 
+int RGWGC::get_shard_status(int index, RGWGCShardStatus *status)
+{
+  for (int expired = 0; expired < 2; expired++) {
+    string marker;
+    bool truncated;
+    uint64_t count = 0;
+    do {
+      std::list<cls_rgw_gc_obj_info> entries;
+      string next_marker;
+      int ret = cls_rgw_gc_list(store->gc_pool_ctx, obj_names[index], marker, 1000, expired, entries, &truncated, &next_marker);
+      if (ret == -ENOENT)
+        break;
+      if (ret < 0)
+        return ret;
+      count += entries.size();
+      marker = next_marker;
+    } while (truncated && !marker.empty());
+
+    if (expired)
+      status->num_expired = count;
+    else
+      status->num_entries = count;
+  }
+  return 0;
+}
+
 bool RGWGC::going_down()
 {
   return (down_flag.read() != 0);
@@ -5,6 +5,8 @@
 #define CEPH_RGW_GC_H
 
 
+#include <deque>
+
 #include "include/types.h"
 #include "include/atomic.h"
 #include "include/rados/librados.hpp"
@@ -15,7 +17,18 @@
 #include "rgw_rados.h"
 #include "cls/rgw/cls_rgw_types.h"
 
+class RGWGCIOManager;
+
+struct RGWGCShardStatus {
+  uint64_t num_entries;
+  uint64_t num_expired;
+
+  RGWGCShardStatus() : num_entries(0), num_expired(0) {}
+};
+
 class RGWGC {
+  friend class RGWGCIOManager;
+
   CephContext *cct;
   RGWRados *store;
   int max_objs;
@@ -47,20 +60,76 @@ public:
   void add_chain(librados::ObjectWriteOperation& op, cls_rgw_obj_chain& chain, const string& tag);
   int send_chain(cls_rgw_obj_chain& chain, const string& tag, bool sync);
   int defer_chain(const string& tag, bool sync);
-  int remove(int index, const std::list<string>& tags);
+  int remove(int index, const std::list<string>& tags, bool sync = true);
 
   void initialize(CephContext *_cct, RGWRados *_store);
   void finalize();
 
   int list(int *index, string& marker, uint32_t max, bool expired_only, std::list<cls_rgw_gc_obj_info>& result, bool *truncated);
   void list_init(int *index) { *index = 0; }
-  int process(int index, int process_max_secs);
+  int process(int index, utime_t end, RGWGCIOManager& io_manager);
   int process();
+  int get_shard_status(int index, RGWGCShardStatus *status);
+  int get_max_objs() { return max_objs; }
 
   bool going_down();
   void start_processor();
   void stop_processor();
 };
 
+/*
+ * Keeps a bounded window of tail object removals in flight, possibly for
+ * several gc shards at once, and collects the tags whose chains were fully
+ * removed so that they can be trimmed from their shard in batches.
+ */
+class RGWGCIOManager {
+  CephContext *cct;
+  RGWGC *gc;
+  size_t max_aio;
+
+  struct IO {
+    librados::AioCompletion *c;
+    int index;
+    string tag;
+    string oid;
+  };
+
+  struct TagState {
+    int pending;
+    bool scheduled; /* all ios of the chain have been issued */
+    bool failed;
+
+    TagState() : pending(0), scheduled(false), failed(false) {}
+  };
+
+  std::deque<IO> ios;
+  map<string, TagState> tags;
+  map<int, std::list<string> > remove_tags;
+
+  void throttle_foreground();
+  void handle_next_completion();
+  void finish_tag(int index, const string& tag);
+  void flush_remove_tags(int index, size_t min_size);
+
+protected:
+  /* trim fully removed tags from their gc shard */
+  virtual int trim_tags(int index, const std::list<string>& tags);
+
+public:
+  RGWGCIOManager(CephContext *_cct, RGWGC *_gc) : cct(_cct), gc(_gc),
+    max_aio(MAX(1, cct->_conf->rgw_gc_max_concurrent_io)) {}
+  virtual ~RGWGCIOManager() {
+    drain();
+  }
+
+  void start_tag(const string& tag);
+  int schedule_io(librados::IoCtx *ioctx, const string& oid, librados::ObjectWriteOperation *op,
+                  int index, const string& tag);
+  void fail_tag(const string& tag);
+  void end_tag(int index, const string& tag);
+  void drain();
+
+  size_t get_num_ios() const { return ios.size(); }
+};
 
 #endif
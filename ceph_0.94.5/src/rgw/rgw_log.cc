@@ -6,6 +6,7 @@
 #include "common/utf8.h"
 #include "common/OutputDataSocket.h"
 #include "common/Formatter.h"
+#include "include/ceph_hash.h"
 
 #include "rgw_log.h"
 #include "rgw_acl.h"
@@ -80,16 +81,33 @@ string render_log_object_name(const string& format,
   return o;
 }
 
+/*
+ * request threads append to the log buffers of their own stripe, so that
+ * logging a request only contends with the (rare) threads that hash to the
+ * same stripe and with the periodic flush
+ */
+static unsigned log_stripe(size_t num_stripes)
+{
+  pthread_t self = pthread_self();
+  return ceph_str_hash_linux((const char *)&self, sizeof(self)) % num_stripes;
+}
+
 /* usage logger */
 class UsageLogger {
+  struct Stripe {
+    Mutex lock;
+    map<rgw_user_bucket, RGWUsageBatch> usage_map;
+    utime_t round_timestamp;
+
+    Stripe() : lock("UsageLogger::Stripe") {}
+  };
+
   CephContext *cct;
   RGWRados *store;
-  map<rgw_user_bucket, RGWUsageBatch> usage_map;
-  Mutex lock;
-  int32_t num_entries;
+  vector<Stripe *> stripes;
+  atomic_t num_entries;
   Mutex timer_lock;
   SafeTimer timer;
-  utime_t round_timestamp;
 
   class C_UsageLogTimeout : public Context {
     UsageLogger *logger;
@@ -106,12 +124,17 @@ class UsageLogger {
   }
 public:
 
-  UsageLogger(CephContext *_cct, RGWRados *_store) : cct(_cct), store(_store), lock("UsageLogger"), num_entries(0), timer_lock("UsageLogger::timer_lock"), timer(cct, timer_lock) {
+  UsageLogger(CephContext *_cct, RGWRados *_store) : cct(_cct), store(_store), num_entries(0), timer_lock("UsageLogger::timer_lock"), timer(cct, timer_lock) {
+    utime_t ts = ceph_clock_now(cct);
+    int num_stripes = MAX(1, cct->_conf->rgw_log_buffer_stripes);
+    for (int i = 0; i < num_stripes; i++) {
+      Stripe *stripe = new Stripe;
+      stripe->round_timestamp = ts.round_to_hour();
+      stripes.push_back(stripe);
+    }
     timer.init();
     Mutex::Locker l(timer_lock);
     set_timer();
-    utime_t ts = ceph_clock_now(cct);
-    recalc_round_timestamp(ts);
   }
 
   ~UsageLogger() {
@@ -119,24 +142,24 @@ public:
     flush();
     timer.cancel_all_events();
     timer.shutdown();
-  }
-
-  void recalc_round_timestamp(utime_t& ts) {
-    round_timestamp = ts.round_to_hour();
+    for (vector<Stripe *>::iterator iter = stripes.begin(); iter != stripes.end(); ++iter) {
+      delete *iter;
+    }
   }
 
   void insert(utime_t& timestamp, rgw_usage_log_entry& entry) {
-    lock.Lock();
-    if (timestamp.sec() > round_timestamp + 3600)
-      recalc_round_timestamp(timestamp);
-    entry.epoch = round_timestamp.sec();
+    Stripe *stripe = stripes[log_stripe(stripes.size())];
+    stripe->lock.Lock();
+    if (timestamp.sec() > stripe->round_timestamp + 3600)
+      stripe->round_timestamp = timestamp.round_to_hour();
+    entry.epoch = stripe->round_timestamp.sec();
     bool account;
     rgw_user_bucket ub(entry.owner, entry.bucket);
-    usage_map[ub].insert(round_timestamp, entry, &account);
+    stripe->usage_map[ub].insert(stripe->round_timestamp, entry, &account);
+    stripe->lock.Unlock();
+    bool need_flush = false;
     if (account)
-      num_entries++;
-    bool need_flush = (num_entries > cct->_conf->rgw_usage_log_flush_threshold);
-    lock.Unlock();
+      need_flush = ((int)num_entries.inc() > cct->_conf->rgw_usage_log_flush_threshold);
     if (need_flush) {
       Mutex::Locker l(timer_lock);
       flush();
@@ -145,12 +168,33 @@ public:
 
   void flush() {
     map<rgw_user_bucket, RGWUsageBatch> old_map;
-    lock.Lock();
-    old_map.swap(usage_map);
-    num_entries = 0;
-    lock.Unlock();
+    num_entries.set(0);
+    for (vector<Stripe *>::iterator iter = stripes.begin(); iter != stripes.end(); ++iter) {
+      map<rgw_user_bucket, RGWUsageBatch> stripe_map;
+      Stripe *stripe = *iter;
+      stripe->lock.Lock();
+      stripe_map.swap(stripe->usage_map);
+      stripe->lock.Unlock();
+
+      if (old_map.empty()) {
+        old_map.swap(stripe_map);
+        continue;
+      }
+      /* the same user/bucket may have been logged from several stripes */
+      map<rgw_user_bucket, RGWUsageBatch>::iterator miter;
+      for (miter = stripe_map.begin(); miter != stripe_map.end(); ++miter) {
+        RGWUsageBatch& batch = old_map[miter->first];
+        map<utime_t, rgw_usage_log_entry>::iterator eiter;
+        for (eiter = miter->second.m.begin(); eiter != miter->second.m.end(); ++eiter) {
+          utime_t ts = eiter->first;
+          bool account;
+          batch.insert(ts, eiter->second, &account);
+        }
+      }
+    }
 
-    store->log_usage(old_map);
+    if (!old_map.empty())
+      store->log_usage(old_map);
   }
 };
 
@@ -167,6 +211,127 @@ void rgw_log_usage_finalize()
   usage_logger = NULL;
 }
 
+/*
+ * ops log buffer: encoded rgw_log_entry records are accumulated per log
+ * object and written with a single append per object every
+ * rgw_ops_log_flush_interval seconds (or once rgw_ops_log_flush_bytes are
+ * pending), instead of one rados append per request.  The log objects
+ * keep their format, a concatenation of encoded entries.
+ */
+class OpsLogBuffer {
+  struct Stripe {
+    Mutex lock;
+    map<string, bufferlist> pending;
+
+    Stripe() : lock("OpsLogBuffer::Stripe") {}
+  };
+
+  CephContext *cct;
+  RGWRados *store;
+  vector<Stripe *> stripes;
+  atomic_t pending_bytes;
+  Mutex timer_lock;
+  SafeTimer timer;
+
+  class C_OpsLogTimeout : public Context {
+    OpsLogBuffer *buffer;
+  public:
+    C_OpsLogTimeout(OpsLogBuffer *_b) : buffer(_b) {}
+    void finish(int r) {
+      buffer->flush();
+      buffer->set_timer();
+    }
+  };
+
+  void set_timer() {
+    timer.add_event_after(cct->_conf->rgw_ops_log_flush_interval, new C_OpsLogTimeout(this));
+  }
+
+  int append(const string& oid, bufferlist& bl) {
+    rgw_obj obj(store->zone.log_pool, oid);
+    int ret = store->append_async(obj, bl.length(), bl);
+    if (ret == -ENOENT) {
+      ret = store->create_pool(store->zone.log_pool);
+      if (ret < 0)
+        return ret;
+      // retry
+      ret = store->append_async(obj, bl.length(), bl);
+    }
+    return ret;
+  }
+public:
+  OpsLogBuffer(CephContext *_cct, RGWRados *_store) : cct(_cct), store(_store), pending_bytes(0),
+                                                      timer_lock("OpsLogBuffer::timer_lock"), timer(cct, timer_lock) {
+    int num_stripes = MAX(1, cct->_conf->rgw_log_buffer_stripes);
+    for (int i = 0; i < num_stripes; i++) {
+      stripes.push_back(new Stripe);
+    }
+    timer.init();
+    Mutex::Locker l(timer_lock);
+    set_timer();
+  }
+
+  ~OpsLogBuffer() {
+    Mutex::Locker l(timer_lock);
+    flush();
+    timer.cancel_all_events();
+    timer.shutdown();
+    for (vector<Stripe *>::iterator iter = stripes.begin(); iter != stripes.end(); ++iter) {
+      delete *iter;
+    }
+  }
+
+  void insert(const string& oid, bufferlist& bl) {
+    Stripe *stripe = stripes[log_stripe(stripes.size())];
+    unsigned len = bl.length();
+    stripe->lock.Lock();
+    stripe->pending[oid].claim_append(bl);
+    stripe->lock.Unlock();
+    pending_bytes.add(len);
+    if (pending_bytes.read() > (unsigned)cct->_conf->rgw_ops_log_flush_bytes) {
+      Mutex::Locker l(timer_lock);
+      flush();
+    }
+  }
+
+  void flush() {
+    map<string, bufferlist> old_map;
+    pending_bytes.set(0);
+    for (vector<Stripe *>::iterator iter = stripes.begin(); iter != stripes.end(); ++iter) {
+      map<string, bufferlist> stripe_map;
+      Stripe *stripe = *iter;
+      stripe->lock.Lock();
+      stripe_map.swap(stripe->pending);
+      stripe->lock.Unlock();
+
+      for (map<string, bufferlist>::iterator miter = stripe_map.begin(); miter != stripe_map.end(); ++miter) {
+        old_map[miter->first].claim_append(miter->second);
+      }
+    }
+
+    for (map<string, bufferlist>::iterator miter = old_map.begin(); miter != old_map.end(); ++miter) {
+      int ret = append(miter->first, miter->second);
+      if (ret < 0) {
+        ldout(cct, 0) << "ERROR: failed to flush ops log to " << miter->first << " ret=" << ret << dendl;
+      }
+    }
+  }
+};
+
+static OpsLogBuffer *ops_log_buffer = NULL;
+
+void rgw_log_ops_init(CephContext *cct, RGWRados *store)
+{
+  if (cct->_conf->rgw_ops_log_flush_interval > 0)
+    ops_log_buffer = new OpsLogBuffer(cct, store);
+}
+
+void rgw_log_ops_finalize()
+{
+  delete ops_log_buffer;
+  ops_log_buffer = NULL;
+}
+
 static void log_usage(struct req_state *s, const string& op_name)
 {
   if (s->system_request) /* don't log system user operations */
@@ -349,15 +514,19 @@ int rgw_log_op(RGWRados *store, struct req_state *s, const string& op_name, OpsL
     string oid = render_log_object_name(s->cct->_conf->rgw_log_object_name, &bdt,
 				        s->bucket.bucket_id, entry.bucket);
 
-    rgw_obj obj(store->zone.log_pool, oid);
+    if (ops_log_buffer) {
+      ops_log_buffer->insert(oid, bl);
+    } else {
+      rgw_obj obj(store->zone.log_pool, oid);
 
-    ret = store->append_async(obj, bl.length(), bl);
-    if (ret == -ENOENT) {
-      ret = store->create_pool(store->zone.log_pool);
-      if (ret < 0)
-        goto done;
-      // retry
       ret = store->append_async(obj, bl.length(), bl);
+      if (ret == -ENOENT) {
+        ret = store->create_pool(store->zone.log_pool);
+        if (ret < 0)
+          goto done;
+        // retry
+        ret = store->append_async(obj, bl.length(), bl);
+      }
     }
   }
 
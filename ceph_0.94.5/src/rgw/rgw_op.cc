@@ -450,11 +450,33 @@ static void rgw_bucket_object_pre_exec(struct req_state *s)
   dump_bucket_from_state(s);
 }
 
+bool RGWGetObj::prefetch_data()
+{
+  if (!get_data)
+    return false;
+
+  /* the head is prefetched along with the attrs so that small objects are
+   * served with a single read; a ranged read that starts past the first
+   * chunk would just throw that data away */
+  const char *range = s->info.env->get("HTTP_RANGE");
+  if (range) {
+    off_t range_ofs = 0;
+    off_t range_end = -1;
+    bool partial = false;
+    if (parse_range(range, range_ofs, range_end, &partial) >= 0 && partial &&
+        range_ofs >= (off_t)s->cct->_conf->rgw_max_chunk_size) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
 int RGWGetObj::verify_permission()
 {
   obj = rgw_obj(s->bucket, s->object);
   store->set_atomic(s->obj_ctx, obj);
-  if (get_data)
+  if (prefetch_data())
     store->set_prefetch_data(s->obj_ctx, obj);
 
   if (!verify_object_permission(s, RGW_PERM_READ))
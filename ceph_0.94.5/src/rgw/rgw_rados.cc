@@ -635,7 +635,7 @@ void RGWObjManifest::obj_iterator::operator++()
     stripe_size = 0;
   }
 
-  dout(0) << "RGWObjManifest::operator++(): result: ofs=" << ofs << " stripe_ofs=" << stripe_ofs << " part_ofs=" << part_ofs << " rule->part_size=" << rule->part_size << dendl;
+  dout(20) << "RGWObjManifest::operator++(): result: ofs=" << ofs << " stripe_ofs=" << stripe_ofs << " part_ofs=" << part_ofs << " rule->part_size=" << rule->part_size << dendl;
   update_location();
 }
 
@@ -728,8 +728,11 @@ RGWObjManifest::obj_iterator RGWObjManifest::obj_find(uint64_t ofs)
   if (ofs > obj_size) {
     ofs = obj_size;
   }
-  RGWObjManifest::obj_iterator iter(this);
-  iter.seek(ofs);
+  /* seek straight to the stripe, the single-arg constructor would seek(0) first */
+  RGWObjManifest::obj_iterator iter(this, ofs);
+  if (empty()) {
+    iter.seek(ofs);
+  }
   return iter;
 }
 
@@ -1359,6 +1362,193 @@ public:
   }
 };
 
+/*
+ * Coalesces bucket index complete ops per index shard object.  Ops queued
+ * within rgw_bucket_index_complete_batch_window_ms are sent as a single
+ * bucket_complete_op_batch cls call, so the shard sees one omap transaction
+ * and one header update for the whole batch instead of one per object.
+ */
+class RGWIndexCompletionBatcher : public Thread {
+  typedef pair<int64_t, string> shard_key_t;
+
+  struct Batch {
+    librados::IoCtx index_ctx;
+    string oid;
+    list<rgw_cls_obj_complete_op> ops;
+    set<cls_rgw_obj_key> keys;
+
+    bool conflicts(rgw_cls_obj_complete_op& op) {
+      if (keys.count(op.key))
+        return true;
+      for (list<cls_rgw_obj_key>::iterator iter = op.remove_objs.begin(); iter != op.remove_objs.end(); ++iter) {
+        if (keys.count(*iter))
+          return true;
+      }
+      return false;
+    }
+    void add(rgw_cls_obj_complete_op& op) {
+      ops.push_back(op);
+      keys.insert(op.key);
+      keys.insert(op.remove_objs.begin(), op.remove_objs.end());
+    }
+  };
+
+  CephContext *cct;
+  Mutex lock;
+  Cond cond;
+  Cond space_cond;
+  bool stopping;
+  bool batch_unsupported;
+
+  /* a shard may have more than one batch when the same key shows up twice */
+  map<shard_key_t, list<Batch> > pending;
+  /* ops queued or being flushed, not yet acknowledged by the osds */
+  uint64_t num_unacked;
+
+  void flush(map<shard_key_t, list<Batch> >& batches);
+  void send_single(Batch& batch);
+
+public:
+  RGWIndexCompletionBatcher(CephContext *_cct) : cct(_cct), lock("RGWIndexCompletionBatcher"),
+                                                 stopping(false), batch_unsupported(false),
+                                                 num_unacked(0) {}
+
+  void add(librados::IoCtx& index_ctx, const string& oid, rgw_cls_obj_complete_op& op);
+  void *entry();
+  void stop();
+};
+
+void RGWIndexCompletionBatcher::add(librados::IoCtx& index_ctx, const string& oid, rgw_cls_obj_complete_op& op)
+{
+  Mutex::Locker l(lock);
+  /*
+   * the request is acked before its op reaches the index, so don't let a
+   * slow index osd pile up an unbounded backlog of ops that a restart would
+   * lose; wait for the current flush to drain instead.
+   */
+  int64_t max_pending = cct->_conf->rgw_bucket_index_complete_max_pending;
+  while (max_pending > 0 && num_unacked >= (uint64_t)max_pending && !stopping) {
+    cond.Signal();
+    space_cond.Wait(lock);
+  }
+  list<Batch>& batches = pending[shard_key_t(index_ctx.get_id(), oid)];
+  if (batches.empty() || batches.back().conflicts(op)) {
+    batches.push_back(Batch());
+    batches.back().index_ctx.dup(index_ctx);
+    batches.back().oid = oid;
+  }
+  Batch& batch = batches.back();
+  batch.add(op);
+  num_unacked++;
+  if (batch.ops.size() >= (size_t)cct->_conf->rgw_bucket_index_complete_batch_max) {
+    cond.Signal();
+  }
+}
+
+void RGWIndexCompletionBatcher::send_single(Batch& batch)
+{
+  list<AioCompletion *> inflight;
+  for (list<rgw_cls_obj_complete_op>::iterator iter = batch.ops.begin(); iter != batch.ops.end(); ++iter) {
+    rgw_cls_obj_complete_op& op = *iter;
+    ObjectWriteOperation o;
+    cls_rgw_bucket_complete_op(o, op.op, op.tag, op.ver, op.key, op.meta, &op.remove_objs,
+                               op.log_op, op.bilog_flags);
+    AioCompletion *c = librados::Rados::aio_create_completion(NULL, NULL, NULL);
+    int r = batch.index_ctx.aio_operate(batch.oid, c, &o);
+    if (r < 0) {
+      c->release();
+      continue;
+    }
+    inflight.push_back(c);
+  }
+  /* the ops only count as acked once the osd has them */
+  for (list<AioCompletion *>::iterator iter = inflight.begin(); iter != inflight.end(); ++iter) {
+    (*iter)->wait_for_complete();
+    (*iter)->release();
+  }
+}
+
+void RGWIndexCompletionBatcher::flush(map<shard_key_t, list<Batch> >& batches)
+{
+  list<pair<Batch *, AioCompletion *> > inflight;
+
+  for (map<shard_key_t, list<Batch> >::iterator iter = batches.begin(); iter != batches.end(); ++iter) {
+    for (list<Batch>::iterator biter = iter->second.begin(); biter != iter->second.end(); ++biter) {
+      Batch& batch = *biter;
+      if (batch_unsupported || batch.ops.size() == 1) {
+        send_single(batch);
+        continue;
+      }
+      ldout(cct, 20) << "index complete batch: oid=" << batch.oid << " ops=" << batch.ops.size() << dendl;
+      ObjectWriteOperation o;
+      cls_rgw_bucket_complete_op_batch(o, batch.ops);
+      AioCompletion *c = librados::Rados::aio_create_completion(NULL, NULL, NULL);
+      int r = batch.index_ctx.aio_operate(batch.oid, c, &o);
+      if (r < 0) {
+        ldout(cct, 0) << "ERROR: failed to send index complete batch oid=" << batch.oid << " r=" << r << dendl;
+        c->release();
+        continue;
+      }
+      inflight.push_back(make_pair(&batch, c));
+    }
+  }
+
+  for (list<pair<Batch *, AioCompletion *> >::iterator iter = inflight.begin(); iter != inflight.end(); ++iter) {
+    AioCompletion *c = iter->second;
+    c->wait_for_complete();
+    int r = c->get_return_value();
+    c->release();
+    if (r == -EOPNOTSUPP) {
+      /* osds don't know the batch call yet, keep sending ops one at a time */
+      ldout(cct, 1) << "bucket_complete_op_batch not supported by osds, disabling index completion batching" << dendl;
+      batch_unsupported = true;
+      send_single(*iter->first);
+    } else if (r < 0) {
+      ldout(cct, 0) << "ERROR: index complete batch oid=" << iter->first->oid << " returned r=" << r
+                    << ", pending entries will be fixed by dir_suggest_changes" << dendl;
+    }
+  }
+}
+
+void *RGWIndexCompletionBatcher::entry()
+{
+  lock.Lock();
+  while (true) {
+    if (pending.empty() && !stopping) {
+      cond.Wait(lock);
+      continue;
+    }
+    if (!stopping) {
+      /* give the window a chance to fill up, unless a batch is already full */
+      utime_t window;
+      window.set_from_double(cct->_conf->rgw_bucket_index_complete_batch_window_ms / 1000.0);
+      cond.WaitInterval(cct, lock, window);
+    }
+    map<shard_key_t, list<Batch> > batches;
+    batches.swap(pending);
+    uint64_t num_flushed = num_unacked;
+    lock.Unlock();
+    flush(batches);
+    lock.Lock();
+    num_unacked -= num_flushed;
+    space_cond.Signal();
+    if (stopping && pending.empty())
+      break;
+  }
+  lock.Unlock();
+  return NULL;
+}
+
+void RGWIndexCompletionBatcher::stop()
+{
+  lock.Lock();
+  stopping = true;
+  cond.Signal();
+  space_cond.Signal();
+  lock.Unlock();
+  join();
+}
+
 RGWObjState *RGWObjectCtx::get_state(rgw_obj& obj) {
   if (!obj.get_object().empty()) {
     return &objs_state[obj];
@@ -1444,6 +1634,11 @@ void RGWRados::finalize()
      */
     delete finisher;
   }
+  if (index_completion_batcher) {
+    index_completion_batcher->stop();
+    delete index_completion_batcher;
+    index_completion_batcher = NULL;
+  }
   delete meta_mgr;
   delete data_log;
   if (use_gc_thread) {
@@ -1629,6 +1824,11 @@ int RGWRados::init_complete()
 
   quota_handler = RGWQuotaHandler::generate_handler(this, quota_threads);
 
+  if (cct->_conf->rgw_bucket_index_complete_batch_window_ms > 0) {
+    index_completion_batcher = new RGWIndexCompletionBatcher(cct);
+    index_completion_batcher->create();
+  }
+
   bucket_index_max_shards = (cct->_conf->rgw_override_bucket_index_max_shards ? cct->_conf->rgw_override_bucket_index_max_shards :
                              zone_public_config.bucket_index_max_shards);
   if (bucket_index_max_shards > MAX_BUCKET_INDEX_SHARDS_PRIME) {
@@ -7934,6 +8134,16 @@ int RGWRados::process_gc()
   return gc->process();
 }
 
+int RGWRados::get_gc_max_objs()
+{
+  return gc->get_max_objs();
+}
+
+int RGWRados::get_gc_shard_status(int index, RGWGCShardStatus *status)
+{
+  return gc->get_shard_status(index, status);
+}
+
 int RGWRados::cls_rgw_init_index(librados::IoCtx& index_ctx, librados::ObjectWriteOperation& op, string& oid)
 {
   bufferlist in;
@@ -7984,6 +8194,22 @@ int RGWRados::cls_obj_complete_op(BucketShard& bs, RGWModifyOp op, string& tag,
   ver.pool = pool;
   ver.epoch = epoch;
   cls_rgw_obj_key key(ent.key.name, ent.key.instance);
+
+  if (index_completion_batcher) {
+    rgw_cls_obj_complete_op call;
+    call.op = op;
+    call.tag = tag;
+    call.key = key;
+    call.ver = ver;
+    call.meta = dir_meta;
+    call.log_op = zone_public_config.log_data;
+    call.bilog_flags = bilog_flags;
+    if (pro)
+      call.remove_objs = *pro;
+    index_completion_batcher->add(bs.index_ctx, bs.bucket_obj, call);
+    return 0;
+  }
+
   cls_rgw_bucket_complete_op(o, op, tag, ver, key, dir_meta, pro,
                              zone_public_config.log_data, bilog_flags);
 
@@ -21,6 +21,7 @@ class RGWWatcher;
 class SafeTimer;
 class ACLOwner;
 class RGWGC;
+struct RGWGCShardStatus;
 
 /* flags for put_obj_meta() */
 #define PUT_OBJ_CREATE      0x01
@@ -1163,6 +1164,7 @@ struct RGWObjectCtx {
 };
 
 class Finisher;
+class RGWIndexCompletionBatcher;
 
 class RGWRados
 {
@@ -1212,6 +1214,8 @@ class RGWRados
   bool use_gc_thread;
   bool quota_threads;
 
+  RGWIndexCompletionBatcher *index_completion_batcher;
+
   int num_watchers;
   RGWWatcher **watchers;
   std::set<int> watchers_set;
@@ -1265,6 +1269,7 @@ protected:
 public:
   RGWRados() : max_req_id(0), lock("rados_timer_lock"), watchers_lock("watchers_lock"), timer(NULL),
                gc(NULL), use_gc_thread(false), quota_threads(false),
+               index_completion_batcher(NULL),
                num_watchers(0), watchers(NULL),
                watch_initialized(false),
                bucket_id_lock("rados_bucket_id"),
@@ -2077,6 +2082,8 @@ public:
 
   int list_gc_objs(int *index, string& marker, uint32_t max, bool expired_only, std::list<cls_rgw_gc_obj_info>& result, bool *truncated);
   int process_gc();
+  int get_gc_max_objs();
+  int get_gc_shard_status(int index, RGWGCShardStatus *status);
   int defer_gc(void *ctx, rgw_obj& obj);
 
   int bucket_check_index(rgw_bucket& bucket,
@@ -8,3 +8,8 @@
   osdmaptool: osdmap file 'myosdmap'
   osdmaptool: imported 491 byte crush map from oc
   osdmaptool: writing epoch 3 to myosdmap
+  $ osdmaptool --compare-crush oc myosdmap
+  osdmaptool: osdmap file 'myosdmap'
+  pool 0 pg_num 192 remapped 0 shards 0
+  #osd\tpgs_in\tpgs_out (esc)
+   remapped 0 of 192 pgs (0%), 0 shards
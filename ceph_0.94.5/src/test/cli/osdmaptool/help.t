@@ -10,4 +10,7 @@
      --test-random           do random placements
      --test-map-pg <pgid>    map a pgid to osds
      --test-map-object <objectname> [--pool <poolid>] map an object to osds
+     --compare-crush <file> [--pool <poolid>] [--pg-bytes <pgdump>] show pg movement if the crush map were <file>
+     --optimize-weights [--pool <poolid>] [--pg-bytes <pgdump>] [--max-change <f>] [--max-rounds <n>]
+                             adjust osd reweights to even out utilization
   [1]
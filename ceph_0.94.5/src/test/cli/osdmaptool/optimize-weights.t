@@ -0,0 +1,51 @@
+  $ NUM_OSDS=40
+  $ PG_BITS=4
+#
+# create an osdmap with a few hosts worth of devices
+#
+  $ OSD_MAP="osdmap"
+  $ osdmaptool --pg_bits $PG_BITS --createsimple $NUM_OSDS "$OSD_MAP" > /dev/null
+  osdmaptool: osdmap file 'osdmap'
+  $ CRUSH_MAP="crushmap"
+  $ CEPH_ARGS="--debug-crush 0" crushtool --outfn "$CRUSH_MAP" --build --num_osds $NUM_OSDS node straw 4 root straw 0
+  $ osdmaptool --import-crush "$CRUSH_MAP" "$OSD_MAP" > /dev/null
+  osdmaptool: osdmap file 'osdmap'
+  $ OUT="$TESTDIR/out"
+#
+# bad arguments
+#
+  $ osdmaptool --optimize-weights --max-change 2 "$OSD_MAP"
+  osdmaptool: osdmap file 'osdmap'
+  osdmaptool: --max-change must be in (0, 1]
+  [1]
+  $ osdmaptool --optimize-weights --pool 123 "$OSD_MAP"
+  osdmaptool: osdmap file 'osdmap'
+  There is no pool 123
+  [1]
+#
+# with every osd out nothing is expected to get data, so there is nothing
+# to reweight and the map is left alone
+#
+  $ osdmaptool --optimize-weights "$OSD_MAP"
+  osdmaptool: osdmap file 'osdmap'
+  round 0 stddev 0
+  #osd\told wt\tnew wt (esc)
+#
+# --mark-up-in --optimize-weights
+#
+  $ osdmaptool --mark-up-in --optimize-weights --max-rounds 5 "$OSD_MAP" > "$OUT"
+  osdmaptool: osdmap file 'osdmap'
+  $ grep -c '^round 0 stddev [0-9.e-]* max osd\.[0-9]* [0-9.e-]*$' "$OUT"
+  1
+  $ grep -c '^#osd' "$OUT"
+  1
+# every line is a round, a reweight or the write of the new map
+  $ grep -Pv '^(marking all OSDs up and in|round [0-5] stddev [0-9.e-]+ max osd\.\d+ [0-9.e-]+|#osd\told wt\tnew wt|osd\.\d+\t1\t0\.\d+|osdmaptool: writing epoch \d+ to osdmap)$' "$OUT"
+  [1]
+# the map is written if and only if some osd was reweighted
+  $ REWEIGHTED=$(grep -P '^osd\.\d+\t' "$OUT" | wc -l)
+  $ WRITTEN=$(grep '^osdmaptool: writing epoch' "$OUT" | wc -l)
+  $ [ $(($REWEIGHTED > 0)) -eq $WRITTEN ]
+# and the written map carries the new weights
+  $ grep -P '^osd\.\d+\t' "$OUT" | while read osd old new; do osdmaptool --print "$OSD_MAP" 2>/dev/null | grep -q "^$osd .* weight $new " || echo "$osd is not at $new"; done
+  $ rm -f "$OUT" "$OSD_MAP" "$CRUSH_MAP"
@@ -51,6 +51,8 @@
     gc list                    dump expired garbage collection objects (specify
                                --include-all to list all entries, including unexpired)
     gc process                 manually process garbage
+    gc status                  show number of pending and expired gc entries
+                               per gc shard
     metadata get               get metadata info
     metadata put               put metadata info
     metadata rm                remove metadata info
@@ -12,6 +12,7 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <set>
 
 using namespace librados;
 
@@ -394,6 +395,77 @@ static bool cmp_objs(cls_rgw_obj& obj1, cls_rgw_obj& obj2)
 }
 
 
+TEST(cls_rgw, index_complete_batch)
+{
+  string bucket_oid = str_int("bucket", 4);
+
+  OpMgr mgr;
+
+  ObjectWriteOperation *op = mgr.write_op();
+  cls_rgw_bucket_init(*op);
+  ASSERT_EQ(0, ioctx.operate(bucket_oid, op));
+
+  uint64_t obj_size = 1024;
+  list<rgw_cls_obj_complete_op> ops;
+
+  for (int i = 0; i < NUM_OBJS; i++) {
+    string obj = str_int("obj", i);
+    string tag = str_int("tag", i);
+    string loc = str_int("loc", i);
+
+    index_prepare(mgr, ioctx, bucket_oid, CLS_RGW_OP_ADD, tag, obj, loc);
+
+    rgw_cls_obj_complete_op call;
+    call.op = CLS_RGW_OP_ADD;
+    call.tag = tag;
+    call.key = cls_rgw_obj_key(obj, string());
+    call.ver.pool = ioctx.get_id();
+    call.ver.epoch = 1;
+    call.meta.category = 0;
+    call.meta.size = obj_size;
+    call.meta.accounted_size = obj_size;
+    call.log_op = true;
+    ops.push_back(call);
+  }
+
+  /* a complete op whose prepare never happened is skipped, not fatal */
+  rgw_cls_obj_complete_op bad;
+  bad.op = CLS_RGW_OP_ADD;
+  bad.tag = "no-such-tag";
+  bad.key = cls_rgw_obj_key("obj-bad", string());
+  ops.push_back(bad);
+
+  test_stats(ioctx, bucket_oid, 0, 0, 0);
+
+  op = mgr.write_op();
+  cls_rgw_bucket_complete_op_batch(*op, ops);
+  ASSERT_EQ(0, ioctx.operate(bucket_oid, op));
+
+  test_stats(ioctx, bucket_oid, 0, NUM_OBJS, obj_size * NUM_OBJS);
+
+  /* every op in the batch must leave its own bilog entry */
+  bufferlist in, out;
+  cls_rgw_bi_log_list_op call;
+  call.max = NUM_OBJS * 4;
+  ::encode(call, in);
+  ASSERT_EQ(0, ioctx.exec(bucket_oid, "rgw", "bi_log_list", in, out));
+
+  cls_rgw_bi_log_list_ret ret;
+  bufferlist::iterator iter = out.begin();
+  ::decode(ret, iter);
+  ASSERT_FALSE(ret.truncated);
+
+  set<string> ids;
+  set<string> objs;
+  for (list<rgw_bi_log_entry>::iterator p = ret.entries.begin();
+       p != ret.entries.end(); ++p) {
+    ASSERT_TRUE(ids.insert(p->id).second);
+    if (p->state == CLS_RGW_STATE_COMPLETE)
+      objs.insert(p->object);
+  }
+  ASSERT_EQ(NUM_OBJS, (int)objs.size());
+}
+
 TEST(cls_rgw, gc_set)
 {
   /* add chains */
@@ -424,10 +496,18 @@ TEST(cls_rgw, gc_set)
   string marker;
 
   /* list chains, verify truncated */
-  ASSERT_EQ(0, cls_rgw_gc_list(ioctx, oid, marker, 8, true, entries, &truncated));
+  string next_marker;
+  ASSERT_EQ(0, cls_rgw_gc_list(ioctx, oid, marker, 8, true, entries, &truncated, &next_marker));
   ASSERT_EQ(8, (int)entries.size());
   ASSERT_EQ(1, truncated);
 
+  /* the next marker resumes right after the last listed entry */
+  list<cls_rgw_gc_obj_info> rest;
+  ASSERT_EQ(0, cls_rgw_gc_list(ioctx, oid, next_marker, 8, true, rest, &truncated));
+  ASSERT_EQ(2, (int)rest.size());
+  ASSERT_EQ(0, truncated);
+  ASSERT_EQ("chain-8", rest.front().tag);
+
   entries.clear();
 
   /* list all chains, verify not truncated */
@@ -0,0 +1,112 @@
+// -*- mode:C; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+/*
+ * Ceph - scalable distributed file system
+ *
+ * This is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License version 2, as published by the Free Software
+ * Foundation.  See file COPYING.
+ */
+
+#include "mon/MonitorDBStore.h"
+#include "gtest/gtest.h"
+
+#include "common/ceph_argparse.h"
+#include "global/global_init.h"
+#include "global/global_context.h"
+
+static void get_ranges(MonitorDBStore::Transaction& t,
+		       vector<pair<string,string> > *ranges)
+{
+  for (list<MonitorDBStore::Op>::iterator p = t.ops.begin();
+       p != t.ops.end();
+       ++p) {
+    ASSERT_EQ(MonitorDBStore::Transaction::OP_COMPACT, p->type);
+    ASSERT_EQ("osdmap", p->prefix);
+    ranges->push_back(make_pair(p->key, p->endkey));
+  }
+}
+
+TEST(MonitorDBStore, compact_version_range_same_digits)
+{
+  MonitorDBStore::Transaction t;
+  t.compact_version_range("osdmap", 1000, 1500);
+  vector<pair<string,string> > ranges;
+  get_ranges(t, &ranges);
+  ASSERT_EQ(1u, ranges.size());
+  ASSERT_EQ(make_pair(string("1000"), string("1500")), ranges[0]);
+}
+
+TEST(MonitorDBStore, compact_version_range_digit_boundary)
+{
+  MonitorDBStore::Transaction t;
+  t.compact_version_range("osdmap", 999, 1500);
+  vector<pair<string,string> > ranges;
+  get_ranges(t, &ranges);
+  ASSERT_EQ(2u, ranges.size());
+  ASSERT_EQ(make_pair(string("999"), string("999")), ranges[0]);
+  ASSERT_EQ(make_pair(string("1000"), string("1500")), ranges[1]);
+  for (unsigned i = 0; i < ranges.size(); ++i)
+    ASSERT_LE(ranges[i].first, ranges[i].second);
+}
+
+TEST(MonitorDBStore, compact_version_range_small)
+{
+  MonitorDBStore::Transaction t;
+  t.compact_version_range("osdmap", 9, 10);
+  vector<pair<string,string> > ranges;
+  get_ranges(t, &ranges);
+  ASSERT_EQ(2u, ranges.size());
+  ASSERT_EQ(make_pair(string("9"), string("9")), ranges[0]);
+  ASSERT_EQ(make_pair(string("10"), string("10")), ranges[1]);
+}
+
+TEST(MonitorDBStore, compact_version_range_many_bands)
+{
+  MonitorDBStore::Transaction t;
+  t.compact_version_range("osdmap", 5, 12345, "full_");
+  vector<pair<string,string> > ranges;
+  get_ranges(t, &ranges);
+  ASSERT_EQ(5u, ranges.size());
+  ASSERT_EQ(make_pair(string("full_5"), string("full_9")), ranges[0]);
+  ASSERT_EQ(make_pair(string("full_10"), string("full_99")), ranges[1]);
+  ASSERT_EQ(make_pair(string("full_100"), string("full_999")), ranges[2]);
+  ASSERT_EQ(make_pair(string("full_1000"), string("full_9999")), ranges[3]);
+  ASSERT_EQ(make_pair(string("full_10000"), string("full_12345")), ranges[4]);
+}
+
+TEST(MonitorDBStore, compact_version_range_single)
+{
+  MonitorDBStore::Transaction t;
+  t.compact_version_range("osdmap", 0, 0);
+  vector<pair<string,string> > ranges;
+  get_ranges(t, &ranges);
+  ASSERT_EQ(1u, ranges.size());
+  ASSERT_EQ(make_pair(string("0"), string("0")), ranges[0]);
+}
+
+TEST(MonitorDBStore, compact_version_range_max)
+{
+  MonitorDBStore::Transaction t;
+  t.compact_version_range("osdmap", 9999999999999999990ull, (version_t)-1);
+  vector<pair<string,string> > ranges;
+  get_ranges(t, &ranges);
+  ASSERT_EQ(2u, ranges.size());
+  ASSERT_EQ(make_pair(string("9999999999999999990"),
+		      string("9999999999999999999")), ranges[0]);
+  ASSERT_EQ(make_pair(string("10000000000000000000"),
+		      string("18446744073709551615")), ranges[1]);
+}
+
+int main(int argc, char **argv) {
+  vector<const char*> args;
+  argv_to_vec(argc, (const char **)argv, args);
+  env_to_vec(args);
+
+  vector<const char*> def_args;
+  global_init(&def_args, args, CEPH_ENTITY_TYPE_CLIENT, CODE_ENVIRONMENT_UTILITY, 0);
+  common_init_finish(g_ceph_context);
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -82,6 +82,41 @@ TEST(pgmap, min_last_epoch_clean)
 }
 
 
+TEST(pgmap, get_stuck_stats)
+{
+  PGMap pg_map;
+  PGMap::Incremental inc;
+  pg_stat_t ps;
+  utime_t cutoff(1000, 0);
+
+  ps.state = PG_STATE_ACTIVE | PG_STATE_CLEAN;
+  inc.version = 1;
+  inc.pg_stat_updates[pg_t(1,1)] = ps;
+  inc.pg_stat_updates[pg_t(2,1)] = ps;
+  pg_map.apply_incremental(g_ceph_context, inc);
+
+  ceph::unordered_map<pg_t, pg_stat_t> stuck;
+  pg_map.get_stuck_stats(PGMap::STUCK_INACTIVE | PGMap::STUCK_UNCLEAN |
+			 PGMap::STUCK_DEGRADED | PGMap::STUCK_UNDERSIZED |
+			 PGMap::STUCK_STALE, cutoff, stuck);
+  ASSERT_TRUE(stuck.empty());
+
+  ps.state = PG_STATE_ACTIVE | PG_STATE_DEGRADED;
+  ps.last_clean = utime_t(10, 0);
+  ps.last_undegraded = utime_t(2000, 0);
+  inc = PGMap::Incremental();
+  inc.version = 2;
+  inc.pg_stat_updates[pg_t(2,1)] = ps;
+  pg_map.apply_incremental(g_ceph_context, inc);
+
+  pg_map.get_stuck_stats(PGMap::STUCK_INACTIVE, cutoff, stuck);
+  ASSERT_TRUE(stuck.empty());
+  pg_map.get_stuck_stats(PGMap::STUCK_DEGRADED, cutoff, stuck);
+  ASSERT_TRUE(stuck.empty());
+  pg_map.get_stuck_stats(PGMap::STUCK_UNCLEAN, cutoff, stuck);
+  ASSERT_EQ(1u, stuck.size());
+  ASSERT_EQ(1u, stuck.count(pg_t(2,1)));
+}
 
 int main(int argc, char **argv) {
   vector<const char*> args;
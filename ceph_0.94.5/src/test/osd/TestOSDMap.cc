@@ -97,6 +97,52 @@ TEST_F(OSDMapTest, Create) {
   ASSERT_EQ(get_num_osds(), osdmap.get_num_in_osds());
 }
 
+TEST_F(OSDMapTest, PoolToActingOsds) {
+  set_up_map();
+  int64_t pool = osdmap.lookup_pg_pool_name("ec");
+  ASSERT_GE(pool, 0);
+
+  vector<vector<int> > acting;
+  vector<int> primary;
+  osdmap.pool_to_acting_osds(pool, &acting, &primary);
+  unsigned pg_num = osdmap.get_pg_pool(pool)->get_pg_num();
+  ASSERT_EQ(pg_num, acting.size());
+  ASSERT_EQ(pg_num, primary.size());
+  for (unsigned i = 0; i < pg_num; ++i) {
+    vector<int> o;
+    int p;
+    osdmap.pg_to_acting_osds(pg_t(i, pool), &o, &p);
+    ASSERT_EQ(o, acting[i]);
+    ASSERT_EQ(p, primary[i]);
+  }
+}
+
+TEST_F(OSDMapTest, PGMappingCache) {
+  set_up_map();
+  int64_t pool = osdmap.lookup_pg_pool_name("ec");
+  ASSERT_GE(pool, 0);
+  unsigned pg_num = osdmap.get_pg_pool(pool)->get_pg_num();
+
+  vector<vector<int> > up(pg_num), acting(pg_num);
+  vector<int> up_primary(pg_num), acting_primary(pg_num);
+  for (unsigned i = 0; i < pg_num; ++i)
+    osdmap.pg_to_up_acting_osds(pg_t(i, pool), &up[i], &up_primary[i],
+				&acting[i], &acting_primary[i]);
+
+  osdmap.enable_pg_mapping_cache();
+  for (int pass = 0; pass < 2; ++pass) {  // fill, then hit
+    for (unsigned i = 0; i < pg_num; ++i) {
+      vector<int> u, a;
+      int up_p, acting_p;
+      osdmap.pg_to_up_acting_osds(pg_t(i, pool), &u, &up_p, &a, &acting_p);
+      ASSERT_EQ(up[i], u);
+      ASSERT_EQ(up_primary[i], up_p);
+      ASSERT_EQ(acting[i], a);
+      ASSERT_EQ(acting_primary[i], acting_p);
+    }
+  }
+}
+
 TEST_F(OSDMapTest, Features) {
   // with EC pool
   set_up_map();
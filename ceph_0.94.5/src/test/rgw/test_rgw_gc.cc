@@ -0,0 +1,199 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+
+#include "include/types.h"
+#include "rgw/rgw_gc.h"
+#include "test/librados/test.h"
+#include "test/unit.h"
+
+#include <errno.h>
+#include <string>
+#include <vector>
+#include <set>
+
+using namespace librados;
+
+librados::Rados rados;
+librados::IoCtx ioctx;
+string pool_name;
+
+/* records the trims instead of sending them to a gc shard */
+class TestGCIOManager : public RGWGCIOManager {
+protected:
+  int trim_tags(int index, const std::list<string>& tags) {
+    trims.push_back(make_pair(index, tags));
+    return 0;
+  }
+
+public:
+  vector<pair<int, std::list<string> > > trims;
+
+  TestGCIOManager(CephContext *cct, RGWGC *gc) : RGWGCIOManager(cct, gc) {}
+  ~TestGCIOManager() {
+    drain();
+  }
+
+  size_t num_trimmed() {
+    size_t n = 0;
+    for (size_t i = 0; i < trims.size(); i++)
+      n += trims[i].second.size();
+    return n;
+  }
+};
+
+static void set_conf(const char *key, const char *val)
+{
+  g_ceph_context->_conf->set_val(key, val);
+  g_ceph_context->_conf->apply_changes(NULL);
+}
+
+static string str_int(string s, int i)
+{
+  char buf[32];
+  snprintf(buf, sizeof(buf), "-%d", i);
+  s.append(buf);
+
+  return s;
+}
+
+/* must be the first test! */
+TEST(rgw_gc, init)
+{
+  pool_name = get_temp_pool_name();
+  /* create pool */
+  ASSERT_EQ("", create_one_pool_pp(pool_name, rados));
+  ASSERT_EQ(0, rados.ioctx_create(pool_name.c_str(), ioctx));
+}
+
+TEST(rgw_gc, io_manager_throttle)
+{
+  set_conf("rgw_gc_max_concurrent_io", "2");
+  set_conf("rgw_gc_max_trim_chunk", "16");
+
+  RGWGC gc;
+  TestGCIOManager io_manager(g_ceph_context, &gc);
+
+  string tag = "throttle";
+  io_manager.start_tag(tag);
+  for (int i = 0; i < 20; i++) {
+    ObjectWriteOperation op;
+    op.create(false);
+    ASSERT_EQ(0, io_manager.schedule_io(&ioctx, str_int("throttle-obj", i), &op, 0, tag));
+    ASSERT_LE(io_manager.get_num_ios(), 2u);
+  }
+  io_manager.end_tag(0, tag);
+  io_manager.drain();
+
+  ASSERT_EQ(0u, io_manager.get_num_ios());
+  ASSERT_EQ(1u, io_manager.trims.size());
+  ASSERT_EQ(0, io_manager.trims[0].first);
+  ASSERT_EQ(1u, io_manager.trims[0].second.size());
+  ASSERT_EQ(tag, io_manager.trims[0].second.front());
+}
+
+TEST(rgw_gc, io_manager_completions)
+{
+  set_conf("rgw_gc_max_concurrent_io", "4");
+  set_conf("rgw_gc_max_trim_chunk", "16");
+
+  /* an exclusive create of this one fails with -EEXIST */
+  ASSERT_EQ(0, ioctx.create("completions-existing", false));
+
+  RGWGC gc;
+  TestGCIOManager io_manager(g_ceph_context, &gc);
+
+  /* all ios succeed */
+  io_manager.start_tag("good");
+  for (int i = 0; i < 3; i++) {
+    ObjectWriteOperation op;
+    op.create(false);
+    ASSERT_EQ(0, io_manager.schedule_io(&ioctx, str_int("completions-good", i), &op, 1, "good"));
+  }
+  io_manager.end_tag(1, "good");
+
+  /* removing a missing object counts as success */
+  io_manager.start_tag("missing");
+  {
+    ObjectWriteOperation op;
+    op.remove();
+    ASSERT_EQ(0, io_manager.schedule_io(&ioctx, "completions-missing", &op, 1, "missing"));
+  }
+  io_manager.end_tag(1, "missing");
+
+  /* one io of the chain fails */
+  io_manager.start_tag("io-failed");
+  {
+    ObjectWriteOperation op;
+    op.create(false);
+    ASSERT_EQ(0, io_manager.schedule_io(&ioctx, "completions-io-failed", &op, 1, "io-failed"));
+  }
+  {
+    ObjectWriteOperation op;
+    op.create(true);
+    ASSERT_EQ(0, io_manager.schedule_io(&ioctx, "completions-existing", &op, 1, "io-failed"));
+  }
+  io_manager.end_tag(1, "io-failed");
+
+  /* the chain could not be fully scheduled */
+  io_manager.start_tag("tag-failed");
+  {
+    ObjectWriteOperation op;
+    op.create(false);
+    ASSERT_EQ(0, io_manager.schedule_io(&ioctx, "completions-tag-failed", &op, 1, "tag-failed"));
+  }
+  io_manager.fail_tag("tag-failed");
+  io_manager.end_tag(1, "tag-failed");
+
+  /* a chain without tail objects */
+  io_manager.start_tag("empty");
+  io_manager.end_tag(1, "empty");
+
+  io_manager.drain();
+
+  ASSERT_EQ(0u, io_manager.get_num_ios());
+  ASSERT_EQ(1u, io_manager.trims.size());
+  ASSERT_EQ(1, io_manager.trims[0].first);
+
+  std::list<string>& trimmed = io_manager.trims[0].second;
+  std::set<string> trimmed_set(trimmed.begin(), trimmed.end());
+  ASSERT_EQ(3u, trimmed.size());
+  ASSERT_EQ(1u, trimmed_set.count("good"));
+  ASSERT_EQ(1u, trimmed_set.count("missing"));
+  ASSERT_EQ(1u, trimmed_set.count("empty"));
+}
+
+TEST(rgw_gc, io_manager_trim_chunks)
+{
+  set_conf("rgw_gc_max_concurrent_io", "4");
+  set_conf("rgw_gc_max_trim_chunk", "2");
+
+  RGWGC gc;
+  TestGCIOManager io_manager(g_ceph_context, &gc);
+
+  for (int i = 0; i < 5; i++) {
+    string tag = str_int("chunk", i);
+    io_manager.start_tag(tag);
+    ObjectWriteOperation op;
+    op.create(false);
+    ASSERT_EQ(0, io_manager.schedule_io(&ioctx, str_int("chunk-obj", i), &op, 2, tag));
+    io_manager.end_tag(2, tag);
+  }
+  io_manager.drain();
+
+  ASSERT_EQ(5u, io_manager.num_trimmed());
+  ASSERT_EQ(3u, io_manager.trims.size());
+  ASSERT_EQ(2u, io_manager.trims[0].second.size());
+  ASSERT_EQ(2u, io_manager.trims[1].second.size());
+  ASSERT_EQ(1u, io_manager.trims[2].second.size());
+  for (size_t i = 0; i < io_manager.trims.size(); i++) {
+    ASSERT_EQ(2, io_manager.trims[i].first);
+  }
+}
+
+/* must be last test! */
+TEST(rgw_gc, finalize)
+{
+  /* remove pool */
+  ioctx.close();
+  ASSERT_EQ(0, destroy_one_pool_pp(pool_name, rados));
+}
@@ -220,8 +220,18 @@ TEST(TestRGWManifest, multipart) {
   for (iter = m.obj_begin(); iter != m.obj_end(); ++iter) {
     RGWObjManifest::obj_iterator fiter = m.obj_find(iter.get_ofs());
     ASSERT_TRUE(fiter.get_location() == iter.get_location());
+
+    /* a ranged read that lands in the middle of a stripe */
+    uint64_t last = iter.get_stripe_ofs() + iter.get_stripe_size() - 1;
+    fiter = m.obj_find(last);
+    ASSERT_TRUE(fiter.get_location() == iter.get_location());
+    ASSERT_EQ(fiter.get_stripe_ofs(), iter.get_stripe_ofs());
+    ASSERT_EQ(fiter.get_stripe_size(), iter.get_stripe_size());
   }
 
+  RGWObjManifest::obj_iterator fiter = m.obj_find(m.get_obj_size());
+  ASSERT_TRUE(fiter == m.obj_end());
+
   ASSERT_EQ(m.get_obj_size(), num_parts * part_size);
 }
 
@@ -13,6 +13,7 @@
  */
 
 #include <string>
+#include <fstream>
 #include <sys/stat.h>
 
 #include "common/ceph_argparse.h"
@@ -36,9 +37,156 @@ void usage()
   cout << "   --test-map-pg <pgid>    map a pgid to osds" << std::endl;
   cout << "   --test-map-object <objectname> [--pool <poolid>] map an object to osds"
        << std::endl;
+  cout << "   --compare-crush <file> [--pool <poolid>] [--pg-bytes <pgdump>] show pg movement if the crush map were <file>"
+       << std::endl;
+  cout << "   --optimize-weights [--pool <poolid>] [--pg-bytes <pgdump>] [--max-change <f>] [--max-rounds <n>]" << std::endl;
+  cout << "                           adjust osd reweights to even out utilization" << std::endl;
   exit(1);
 }
 
+/**
+ * read per-pg byte counts from the plain output of 'ceph pg dump pgs'.
+ * the column positions are taken from the pg_stat header line.
+ */
+static int read_pg_bytes(const string& fn, map<pg_t,uint64_t> *bytes)
+{
+  ifstream in(fn.c_str());
+  if (!in.is_open())
+    return -ENOENT;
+  int pg_col = -1, bytes_col = -1;
+  string line;
+  while (getline(in, line)) {
+    vector<string> cols;
+    istringstream ss(line);
+    string c;
+    while (ss >> c)
+      cols.push_back(c);
+    if (cols.empty())
+      continue;
+    if (cols[0] == "pg_stat") {
+      pg_col = bytes_col = -1;
+      for (unsigned i = 0; i < cols.size(); ++i) {
+	if (cols[i] == "pg_stat")
+	  pg_col = i;
+	else if (cols[i] == "bytes")
+	  bytes_col = i;
+      }
+      continue;
+    }
+    if (pg_col < 0 || bytes_col < 0 ||
+	(int)cols.size() <= MAX(pg_col, bytes_col))
+      continue;
+    pg_t pgid;
+    if (!pgid.parse(cols[pg_col].c_str()))
+      continue;
+    (*bytes)[pgid] = strtoull(cols[bytes_col].c_str(), NULL, 10);
+  }
+  if (pg_col < 0 || bytes_col < 0)
+    return -EINVAL;
+  return 0;
+}
+
+struct move_stat_t {
+  uint64_t pgs_in, pgs_out, bytes_in, bytes_out;
+  move_stat_t() : pgs_in(0), pgs_out(0), bytes_in(0), bytes_out(0) {}
+};
+
+/// an erasure coded shard holds 1/k of the pg's data
+static unsigned get_shard_divisor(const OSDMap& osdmap, const pg_pool_t& pool)
+{
+  if (pool.can_shift_osds())
+    return 1;
+  unsigned divisor = 0;
+  const map<string,string>& profile =
+    osdmap.get_erasure_code_profile(pool.erasure_code_profile);
+  map<string,string>::const_iterator k = profile.find("k");
+  if (k != profile.end())
+    divisor = atoi(k->second.c_str());
+  if (divisor < 1)
+    divisor = MAX(1u, pool.get_size());
+  return divisor;
+}
+
+/**
+ * map every pg and add up the load (shards, or bytes if we have pg
+ * stats) that each osd gets, and the load it should get given its
+ * share of the crush weight under each pool's rule.
+ */
+static void calc_osd_load(OSDMap& osdmap, int pool,
+			  const map<pg_t,uint64_t>& bytes,
+			  vector<double> *load, vector<double> *expected)
+{
+  int n = osdmap.get_max_osd();
+  load->assign(n, 0);
+  expected->assign(n, 0);
+  const map<int64_t,pg_pool_t>& pools = osdmap.get_pools();
+  for (map<int64_t,pg_pool_t>::const_iterator p = pools.begin();
+       p != pools.end(); ++p) {
+    if (pool != -1 && p->first != pool)
+      continue;
+    unsigned divisor = get_shard_divisor(osdmap, p->second);
+    vector<vector<int> > acting;
+    vector<int> primary;
+    osdmap.pool_to_acting_osds(p->first, &acting, &primary);
+    double total = 0;
+    for (unsigned ps = 0; ps < acting.size(); ++ps) {
+      double shard = 1;
+      if (!bytes.empty()) {
+	map<pg_t,uint64_t>::const_iterator q = bytes.find(pg_t(ps, p->first));
+	shard = q != bytes.end() ? (double)q->second / divisor : 0;
+      }
+      for (vector<int>::iterator i = acting[ps].begin();
+	   i != acting[ps].end(); ++i) {
+	if (*i < 0 || *i >= n)
+	  continue;
+	(*load)[*i] += shard;
+	total += shard;
+      }
+    }
+
+    int ruleno = osdmap.crush->find_rule(p->second.get_crush_ruleset(),
+					 p->second.get_type(),
+					 p->second.get_size());
+    map<int,float> wm;
+    if (ruleno < 0 || osdmap.crush->get_rule_weight_osd_map(ruleno, &wm) < 0)
+      continue;
+    double sum = 0;
+    for (map<int,float>::iterator i = wm.begin(); i != wm.end(); ++i)
+      if (i->first < n && osdmap.is_in(i->first))
+	sum += i->second;
+    if (sum <= 0)
+      continue;
+    for (map<int,float>::iterator i = wm.begin(); i != wm.end(); ++i)
+      if (i->first < n && osdmap.is_in(i->first))
+	(*expected)[i->first] += total * i->second / sum;
+  }
+}
+
+/// stddev of load/expected over the osds that should get data
+static double calc_load_dev(const vector<double>& load,
+			    const vector<double>& expected,
+			    int *max_osd)
+{
+  double sum = 0, sumsq = 0;
+  int count = 0;
+  *max_osd = -1;
+  for (unsigned i = 0; i < load.size(); ++i) {
+    if (expected[i] <= 0)
+      continue;
+    double r = load[i] / expected[i];
+    sum += r;
+    sumsq += r * r;
+    count++;
+    if (*max_osd < 0 ||
+	r > load[*max_osd] / expected[*max_osd])
+      *max_osd = i;
+  }
+  if (!count)
+    return 0;
+  double avg = sum / count;
+  return sqrt(MAX(0.0, sumsq / count - avg * avg));
+}
+
 int main(int argc, const char **argv)
 {
   vector<const char*> args;
@@ -63,6 +211,10 @@ int main(int argc, const char **argv)
   bool clobber = false;
   bool modified = false;
   std::string export_crush, import_crush, test_map_pg, test_map_object;
+  std::string compare_crush, pg_bytes;
+  bool optimize_weights = false;
+  float max_change = .05;
+  int max_rounds = 10;
   bool test_crush = false;
   int range_first = -1;
   int range_last = -1;
@@ -102,6 +254,18 @@ int main(int argc, const char **argv)
       test_map_pgs = true;
     } else if (ceph_argparse_flag(args, i, "--test-map-pgs-dump", (char*)NULL)) {
       test_map_pgs_dump = true;
+    } else if (ceph_argparse_flag(args, i, "--optimize-weights", (char*)NULL)) {
+      optimize_weights = true;
+    } else if (ceph_argparse_withfloat(args, i, &max_change, &err, "--max-change", (char*)NULL)) {
+      if (!err.str().empty()) {
+	cerr << err.str() << std::endl;
+	exit(EXIT_FAILURE);
+      }
+    } else if (ceph_argparse_withint(args, i, &max_rounds, &err, "--max-rounds", (char*)NULL)) {
+      if (!err.str().empty()) {
+	cerr << err.str() << std::endl;
+	exit(EXIT_FAILURE);
+      }
     } else if (ceph_argparse_flag(args, i, "--test-random", (char*)NULL)) {
       test_random = true;
     } else if (ceph_argparse_flag(args, i, "--clobber", (char*)NULL)) {
@@ -120,6 +284,10 @@ int main(int argc, const char **argv)
       export_crush = val;
     } else if (ceph_argparse_witharg(args, i, &val, "--import_crush", (char*)NULL)) {
       import_crush = val;
+    } else if (ceph_argparse_witharg(args, i, &val, "--compare_crush", (char*)NULL)) {
+      compare_crush = val;
+    } else if (ceph_argparse_witharg(args, i, &val, "--pg_bytes", (char*)NULL)) {
+      pg_bytes = val;
     } else if (ceph_argparse_witharg(args, i, &val, "--test_map_pg", (char*)NULL)) {
       test_map_pg = val;
     } else if (ceph_argparse_witharg(args, i, &val, "--test_map_object", (char*)NULL)) {
@@ -260,6 +428,103 @@ int main(int argc, const char **argv)
     modified = true;
   }
 
+  if (optimize_weights) {
+    if (pool != -1 && !osdmap.have_pg_pool(pool)) {
+      cerr << "There is no pool " << pool << std::endl;
+      exit(1);
+    }
+    if (max_change <= 0 || max_change > 1) {
+      cerr << me << ": --max-change must be in (0, 1]" << std::endl;
+      exit(1);
+    }
+    map<pg_t,uint64_t> bytes;
+    if (!pg_bytes.empty()) {
+      r = read_pg_bytes(pg_bytes, &bytes);
+      if (r < 0) {
+	cerr << me << ": error reading pg stats from " << pg_bytes
+	     << ": " << cpp_strerror(r) << std::endl;
+	exit(1);
+      }
+    }
+
+    // try the reweights on a scratch copy; the real map only changes
+    // through the incremental built from the result.
+    OSDMap tmp;
+    tmp.deepish_copy_from(osdmap);
+    int n = tmp.get_max_osd();
+    vector<unsigned> prev_weight(n);
+
+    vector<double> load, expected;
+    calc_osd_load(tmp, pool, bytes, &load, &expected);
+    int max_osd;
+    double dev = calc_load_dev(load, expected, &max_osd);
+    cout << "round 0 stddev " << dev;
+    if (max_osd >= 0)
+      cout << " max osd." << max_osd << " "
+	   << (load[max_osd] / expected[max_osd]);
+    cout << std::endl;
+
+    for (int round = 1; round <= max_rounds; ++round) {
+      // move each osd's reweight toward the value that would give it its
+      // expected load, by at most max_change per round.
+      bool changed = false;
+      for (int i = 0; i < n; i++) {
+	prev_weight[i] = tmp.get_weight(i);
+	if (expected[i] <= 0 || load[i] <= 0)
+	  continue;
+	double w = tmp.get_weightf(i);
+	double target = w * expected[i] / load[i];
+	double nw = MIN(target, w + max_change);
+	nw = MAX(nw, w - max_change);
+	nw = MIN(nw, 1.0);
+	nw = MAX(nw, .01);
+	unsigned wi = (unsigned)(nw * (double)CEPH_OSD_IN);
+	if (wi != prev_weight[i]) {
+	  tmp.set_weight(i, wi);
+	  changed = true;
+	}
+      }
+      if (!changed)
+	break;
+
+      calc_osd_load(tmp, pool, bytes, &load, &expected);
+      int new_max_osd;
+      double new_dev = calc_load_dev(load, expected, &new_max_osd);
+      cout << "round " << round << " stddev " << new_dev;
+      if (new_max_osd >= 0)
+	cout << " max osd." << new_max_osd << " "
+	     << (load[new_max_osd] / expected[new_max_osd]);
+      cout << std::endl;
+      if (new_dev >= dev) {
+	// no better; keep the previous round's weights
+	for (int i = 0; i < n; i++)
+	  tmp.set_weight(i, prev_weight[i]);
+	break;
+      }
+      dev = new_dev;
+    }
+
+    OSDMap::Incremental inc;
+    inc.fsid = osdmap.get_fsid();
+    inc.epoch = osdmap.get_epoch()+1;
+    cout << "#osd\told wt\tnew wt\n";
+    for (int i = 0; i < n; i++) {
+      if (tmp.get_weight(i) == osdmap.get_weight(i))
+	continue;
+      cout << "osd." << i
+	   << "\t" << osdmap.get_weightf(i)
+	   << "\t" << tmp.get_weightf(i)
+	   << std::endl;
+      inc.new_weight[i] = tmp.get_weight(i);
+    }
+
+    // apply
+    if (!inc.new_weight.empty()) {
+      osdmap.apply_incremental(inc);
+      modified = true;
+    }
+  }
+
   if (!export_crush.empty()) {
     bufferlist cbl;
     osdmap.crush->encode(cbl);
@@ -330,6 +595,10 @@ int main(int argc, const char **argv)
 	continue;
       cout << "pool " << p->first
 	   << " pg_num " << p->second.get_pg_num() << std::endl;
+      vector<vector<int> > pool_acting;
+      vector<int> pool_primary;
+      if (!test_random)
+	osdmap.pool_to_acting_osds(p->first, &pool_acting, &pool_primary);
       for (unsigned i = 0; i < p->second.get_pg_num(); ++i) {
 	pg_t pgid = pg_t(i, p->first);
 
@@ -342,7 +611,8 @@ int main(int argc, const char **argv)
 	  }
 	  primary = osds[0];
 	} else {
-	  osdmap.pg_to_acting_osds(pgid, &osds, &primary);
+	  osds.swap(pool_acting[i]);
+	  primary = pool_primary[i];
 	}
 	size[osds.size()]++;
 
@@ -419,6 +689,151 @@ int main(int argc, const char **argv)
       cout << "size " << i << "\t" << size[i] << std::endl;
     }
   }
+  if (!compare_crush.empty()) {
+    if (pool != -1 && !osdmap.have_pg_pool(pool)) {
+      cerr << "There is no pool " << pool << std::endl;
+      exit(1);
+    }
+    bufferlist cbl;
+    std::string error;
+    r = cbl.read_file(compare_crush.c_str(), &error);
+    if (r) {
+      cerr << me << ": error reading crush map from " << compare_crush
+	   << ": " << error << std::endl;
+      exit(1);
+    }
+    CrushWrapper cw;
+    try {
+      bufferlist::iterator p = cbl.begin();
+      cw.decode(p);
+    } catch (const buffer::error &e) {
+      cerr << me << ": error decoding crush map from " << compare_crush
+	   << std::endl;
+      exit(1);
+    }
+    if (cw.get_max_devices() > osdmap.get_max_osd()) {
+      cerr << me << ": crushmap max_devices " << cw.get_max_devices()
+	   << " > osdmap max_osd " << osdmap.get_max_osd() << std::endl;
+      exit(1);
+    }
+
+    map<pg_t,uint64_t> bytes;
+    if (!pg_bytes.empty()) {
+      r = read_pg_bytes(pg_bytes, &bytes);
+      if (r < 0) {
+	cerr << me << ": error reading pg stats from " << pg_bytes
+	     << ": " << cpp_strerror(r) << std::endl;
+	exit(1);
+      }
+      cout << me << ": read bytes for " << bytes.size() << " pgs from "
+	   << pg_bytes << std::endl;
+    }
+
+    OSDMap proposed;
+    proposed.deepish_copy_from(osdmap);
+    OSDMap::Incremental inc;
+    inc.fsid = proposed.get_fsid();
+    inc.epoch = proposed.get_epoch()+1;
+    inc.crush = cbl;
+    proposed.apply_incremental(inc);
+
+    int n = osdmap.get_max_osd();
+    vector<move_stat_t> osd_moves(n);
+    uint64_t total_pgs = 0, total_moved = 0, total_shards = 0, total_bytes = 0;
+    const map<int64_t,pg_pool_t>& pools = osdmap.get_pools();
+    for (map<int64_t,pg_pool_t>::const_iterator p = pools.begin();
+	 p != pools.end(); ++p) {
+      if (pool != -1 && p->first != pool)
+	continue;
+      vector<vector<int> > before, after;
+      vector<int> before_primary, after_primary;
+      osdmap.pool_to_acting_osds(p->first, &before, &before_primary);
+      proposed.pool_to_acting_osds(p->first, &after, &after_primary);
+
+      unsigned divisor = get_shard_divisor(osdmap, p->second);
+
+      uint64_t moved = 0, shards = 0, pool_bytes = 0;
+      for (unsigned ps = 0; ps < before.size(); ++ps) {
+	vector<int> in, out;
+	if (p->second.can_shift_osds()) {
+	  set<int> b(before[ps].begin(), before[ps].end());
+	  set<int> a(after[ps].begin(), after[ps].end());
+	  set_difference(a.begin(), a.end(), b.begin(), b.end(),
+			 back_inserter(in));
+	  set_difference(b.begin(), b.end(), a.begin(), a.end(),
+			 back_inserter(out));
+	} else {
+	  // shards are positional
+	  unsigned m = MAX(before[ps].size(), after[ps].size());
+	  for (unsigned i = 0; i < m; ++i) {
+	    int b = i < before[ps].size() ? before[ps][i] : CRUSH_ITEM_NONE;
+	    int a = i < after[ps].size() ? after[ps][i] : CRUSH_ITEM_NONE;
+	    if (a == b)
+	      continue;
+	    if (a != CRUSH_ITEM_NONE)
+	      in.push_back(a);
+	    if (b != CRUSH_ITEM_NONE)
+	      out.push_back(b);
+	  }
+	}
+	if (in.empty() && out.empty())
+	  continue;
+	moved++;
+	shards += in.size();
+	uint64_t shard_bytes = 0;
+	map<pg_t,uint64_t>::iterator q = bytes.find(pg_t(ps, p->first));
+	if (q != bytes.end())
+	  shard_bytes = q->second / divisor;
+	pool_bytes += shard_bytes * in.size();
+	for (vector<int>::iterator i = in.begin(); i != in.end(); ++i) {
+	  if (*i < 0 || *i >= n)
+	    continue;
+	  osd_moves[*i].pgs_in++;
+	  osd_moves[*i].bytes_in += shard_bytes;
+	}
+	for (vector<int>::iterator i = out.begin(); i != out.end(); ++i) {
+	  if (*i < 0 || *i >= n)
+	    continue;
+	  osd_moves[*i].pgs_out++;
+	  osd_moves[*i].bytes_out += shard_bytes;
+	}
+      }
+      cout << "pool " << p->first
+	   << " pg_num " << p->second.get_pg_num()
+	   << " remapped " << moved
+	   << " shards " << shards;
+      if (!bytes.empty())
+	cout << " bytes " << pool_bytes;
+      cout << std::endl;
+      total_pgs += p->second.get_pg_num();
+      total_moved += moved;
+      total_shards += shards;
+      total_bytes += pool_bytes;
+    }
+
+    cout << "#osd\tpgs_in\tpgs_out";
+    if (!bytes.empty())
+      cout << "\tbytes_in\tbytes_out";
+    cout << "\n";
+    for (int i = 0; i < n; i++) {
+      if (!osd_moves[i].pgs_in && !osd_moves[i].pgs_out)
+	continue;
+      cout << "osd." << i
+	   << "\t" << osd_moves[i].pgs_in
+	   << "\t" << osd_moves[i].pgs_out;
+      if (!bytes.empty())
+	cout << "\t" << osd_moves[i].bytes_in
+	     << "\t" << osd_moves[i].bytes_out;
+      cout << std::endl;
+    }
+    cout << " remapped " << total_moved << " of " << total_pgs << " pgs";
+    if (total_pgs)
+      cout << " (" << (100.0 * total_moved / total_pgs) << "%)";
+    cout << ", " << total_shards << " shards";
+    if (!bytes.empty())
+      cout << ", " << total_bytes << " bytes";
+    cout << std::endl;
+  }
   if (test_crush) {
     int pass = 0;
     while (1) {
@@ -453,6 +868,7 @@ int main(int argc, const char **argv)
   if (!print && !print_json && !tree && !modified && 
       export_crush.empty() && import_crush.empty() && 
       test_map_pg.empty() && test_map_object.empty() &&
+      compare_crush.empty() && !optimize_weights &&
       !test_map_pgs && !test_map_pgs_dump) {
     cerr << me << ": no action specified?" << std::endl;
     usage();